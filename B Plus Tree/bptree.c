@@ -0,0 +1,878 @@
+#define _GNU_SOURCE
+#include "bptree.h"
+
+/**
+ * @brief Returns the address of key index of p_node.
+ */
+static inline uint8_t *
+bptree_key (bptree_t * p_tree, bptree_node_t * p_node, size_t index)
+{
+    return p_node->keys + (index * p_tree->key_size);
+}
+
+/**
+ * @brief Returns the number of keys of p_node ordered at or before p_key,
+ * which is the index of the child whose subtree would hold p_key.
+ */
+static size_t
+bptree_upper_bound (bptree_t * p_tree, bptree_node_t * p_node, void * p_key)
+{
+    size_t low  = 0;
+    size_t high = p_node->num_keys;
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (0 < p_tree->p_compare(bptree_key(p_tree, p_node, middle), p_key))
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Returns the index of the first key of p_node not ordered before
+ * p_key, or num_keys if there is none.
+ */
+static size_t
+bptree_lower_bound (bptree_t * p_tree, bptree_node_t * p_node, void * p_key)
+{
+    size_t low  = 0;
+    size_t high = p_node->num_keys;
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (0 > p_tree->p_compare(bptree_key(p_tree, p_node, middle), p_key))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Allocates a zeroed node starting on a cache line.
+ */
+static bptree_node_t *
+bptree_node_create (bptree_t * p_tree)
+{
+    void * p_node = NULL;
+
+    if (0 != posix_memalign(&p_node, BPTREE_NODE_ALIGNMENT, p_tree->node_size))
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        p_node = NULL;
+        goto EXIT;
+    }
+
+    memset(p_node, 0, p_tree->node_size);
+
+EXIT:
+    return (bptree_node_t *)p_node;
+}
+
+/**
+ * @brief Frees p_node and everything below it, destroying the values of
+ * leaves. The recursion is bounded by BPTREE_MAX_HEIGHT.
+ */
+static void
+bptree_node_destroy (bptree_t * p_tree, bptree_node_t * p_node)
+{
+    for (size_t index = 0; index < p_node->num_keys + !p_node->b_leaf; index++)
+    {
+        if (!p_node->b_leaf)
+        {
+            bptree_node_destroy(p_tree, p_node->p_slots[index]);
+        }
+        else if (NULL != p_tree->p_destroy_function)
+        {
+            p_tree->p_destroy_function(p_node->p_slots[index]);
+        }
+    }
+
+    free(p_node);
+}
+
+/**
+ * @brief Inserts a key and its value at index of a leaf that has room.
+ */
+static void
+bptree_leaf_insert (bptree_t *      p_tree,
+                    bptree_node_t * p_leaf,
+                    size_t          index,
+                    void *          p_key,
+                    void *          p_value)
+{
+    size_t moved = p_leaf->num_keys - index;
+
+    memmove(bptree_key(p_tree, p_leaf, index + 1),
+            bptree_key(p_tree, p_leaf, index),
+            moved * p_tree->key_size);
+    memmove(&p_leaf->p_slots[index + 1],
+            &p_leaf->p_slots[index],
+            moved * sizeof(void *));
+    memcpy(bptree_key(p_tree, p_leaf, index), p_key, p_tree->key_size);
+    p_leaf->p_slots[index] = p_value;
+    p_leaf->num_keys++;
+}
+
+/**
+ * @brief Inserts a separator key at index of an internal node that has room,
+ * with p_child as the child to its right.
+ */
+static void
+bptree_internal_insert (bptree_t *      p_tree,
+                        bptree_node_t * p_node,
+                        size_t          index,
+                        void *          p_key,
+                        bptree_node_t * p_child)
+{
+    size_t moved = p_node->num_keys - index;
+
+    memmove(bptree_key(p_tree, p_node, index + 1),
+            bptree_key(p_tree, p_node, index),
+            moved * p_tree->key_size);
+    memmove(&p_node->p_slots[index + 2],
+            &p_node->p_slots[index + 1],
+            moved * sizeof(void *));
+    memcpy(bptree_key(p_tree, p_node, index), p_key, p_tree->key_size);
+    p_node->p_slots[index + 1] = p_child;
+    p_node->num_keys++;
+}
+
+/**
+ * @brief Splits a full leaf into itself and p_right, then inserts the key
+ * and value into the half where they belong. p_right is linked after the
+ * leaf, and its first key separates the two.
+ */
+static void
+bptree_split_leaf (bptree_t *      p_tree,
+                   bptree_node_t * p_leaf,
+                   bptree_node_t * p_right,
+                   size_t          index,
+                   void *          p_key,
+                   void *          p_value)
+{
+    size_t kept  = BPTREE_MAX_KEYS / 2;
+    size_t moved = BPTREE_MAX_KEYS - kept;
+
+    memcpy(bptree_key(p_tree, p_right, 0),
+           bptree_key(p_tree, p_leaf, kept),
+           moved * p_tree->key_size);
+    memcpy(p_right->p_slots, &p_leaf->p_slots[kept], moved * sizeof(void *));
+
+    p_right->b_leaf   = true;
+    p_right->num_keys = moved;
+    p_right->p_next   = p_leaf->p_next;
+    p_leaf->num_keys  = kept;
+    p_leaf->p_next    = p_right;
+
+    if (index <= kept)
+    {
+        bptree_leaf_insert(p_tree, p_leaf, index, p_key, p_value);
+    }
+    else
+    {
+        bptree_leaf_insert(p_tree, p_right, index - kept, p_key, p_value);
+    }
+}
+
+/**
+ * @brief Splits a full internal node into itself and p_right while inserting
+ * the separator p_key, with p_child to its right, at index. Of the
+ * BPTREE_MAX_KEYS + 1 keys, the middle one moves up to the parent and is
+ * copied to p_up; the node keeps those before it and p_right those after.
+ */
+static void
+bptree_split_internal (bptree_t *      p_tree,
+                       bptree_node_t * p_node,
+                       bptree_node_t * p_right,
+                       size_t          index,
+                       void *          p_key,
+                       bptree_node_t * p_child,
+                       uint8_t *       p_up)
+{
+    size_t middle   = (BPTREE_MAX_KEYS + 1) / 2;
+    size_t key_size = p_tree->key_size;
+
+    p_right->b_leaf = false;
+
+    if (index < middle)
+    {
+        memcpy(p_up, bptree_key(p_tree, p_node, middle - 1), key_size);
+        memcpy(bptree_key(p_tree, p_right, 0),
+               bptree_key(p_tree, p_node, middle),
+               (BPTREE_MAX_KEYS - middle) * key_size);
+        memcpy(p_right->p_slots,
+               &p_node->p_slots[middle],
+               (BPTREE_MAX_KEYS - middle + 1) * sizeof(void *));
+        p_right->num_keys = BPTREE_MAX_KEYS - middle;
+        p_node->num_keys  = middle - 1;
+        bptree_internal_insert(p_tree, p_node, index, p_key, p_child);
+    }
+    else if (index == middle)
+    {
+        memcpy(p_up, p_key, key_size);
+        memcpy(bptree_key(p_tree, p_right, 0),
+               bptree_key(p_tree, p_node, middle),
+               (BPTREE_MAX_KEYS - middle) * key_size);
+        p_right->p_slots[0] = p_child;
+        memcpy(&p_right->p_slots[1],
+               &p_node->p_slots[middle + 1],
+               (BPTREE_MAX_KEYS - middle) * sizeof(void *));
+        p_right->num_keys = BPTREE_MAX_KEYS - middle;
+        p_node->num_keys  = middle;
+    }
+    else
+    {
+        memcpy(p_up, bptree_key(p_tree, p_node, middle), key_size);
+        memcpy(bptree_key(p_tree, p_right, 0),
+               bptree_key(p_tree, p_node, middle + 1),
+               (BPTREE_MAX_KEYS - middle - 1) * key_size);
+        memcpy(p_right->p_slots,
+               &p_node->p_slots[middle + 1],
+               (BPTREE_MAX_KEYS - middle) * sizeof(void *));
+        p_right->num_keys = BPTREE_MAX_KEYS - middle - 1;
+        p_node->num_keys  = middle;
+        bptree_internal_insert(
+            p_tree, p_right, index - middle - 1, p_key, p_child);
+    }
+}
+
+/**
+ * @brief Moves the last entry of p_left to the front of p_node, its right
+ * sibling and child index of p_parent, and updates their separator.
+ */
+static void
+bptree_borrow_left (bptree_t *      p_tree,
+                    bptree_node_t * p_parent,
+                    size_t          index,
+                    bptree_node_t * p_left,
+                    bptree_node_t * p_node)
+{
+    size_t    key_size    = p_tree->key_size;
+    size_t    last        = p_left->num_keys - 1;
+    uint8_t * p_separator = bptree_key(p_tree, p_parent, index - 1);
+
+    memmove(bptree_key(p_tree, p_node, 1),
+            bptree_key(p_tree, p_node, 0),
+            p_node->num_keys * key_size);
+    memmove(&p_node->p_slots[1],
+            &p_node->p_slots[0],
+            (p_node->num_keys + !p_node->b_leaf) * sizeof(void *));
+
+    if (p_node->b_leaf)
+    {
+        memcpy(bptree_key(p_tree, p_node, 0),
+               bptree_key(p_tree, p_left, last),
+               key_size);
+        p_node->p_slots[0] = p_left->p_slots[last];
+        memcpy(p_separator, bptree_key(p_tree, p_node, 0), key_size);
+    }
+    else
+    {
+        memcpy(bptree_key(p_tree, p_node, 0), p_separator, key_size);
+        p_node->p_slots[0] = p_left->p_slots[last + 1];
+        memcpy(p_separator, bptree_key(p_tree, p_left, last), key_size);
+    }
+
+    p_left->num_keys--;
+    p_node->num_keys++;
+}
+
+/**
+ * @brief Moves the first entry of p_right to the end of p_node, its left
+ * sibling and child index of p_parent, and updates their separator.
+ */
+static void
+bptree_borrow_right (bptree_t *      p_tree,
+                     bptree_node_t * p_parent,
+                     size_t          index,
+                     bptree_node_t * p_node,
+                     bptree_node_t * p_right)
+{
+    size_t    key_size    = p_tree->key_size;
+    uint8_t * p_separator = bptree_key(p_tree, p_parent, index);
+
+    if (p_node->b_leaf)
+    {
+        memcpy(bptree_key(p_tree, p_node, p_node->num_keys),
+               bptree_key(p_tree, p_right, 0),
+               key_size);
+        p_node->p_slots[p_node->num_keys] = p_right->p_slots[0];
+    }
+    else
+    {
+        memcpy(bptree_key(p_tree, p_node, p_node->num_keys),
+               p_separator,
+               key_size);
+        p_node->p_slots[p_node->num_keys + 1] = p_right->p_slots[0];
+        memcpy(p_separator, bptree_key(p_tree, p_right, 0), key_size);
+    }
+
+    p_node->num_keys++;
+    p_right->num_keys--;
+
+    memmove(bptree_key(p_tree, p_right, 0),
+            bptree_key(p_tree, p_right, 1),
+            p_right->num_keys * key_size);
+    memmove(&p_right->p_slots[0],
+            &p_right->p_slots[1],
+            (p_right->num_keys + !p_right->b_leaf) * sizeof(void *));
+
+    if (p_node->b_leaf)
+    {
+        memcpy(p_separator, bptree_key(p_tree, p_right, 0), key_size);
+    }
+}
+
+/**
+ * @brief Appends p_right, child index + 1 of p_parent, to p_left, child
+ * index, then frees p_right and removes separator index from p_parent.
+ */
+static void
+bptree_merge (bptree_t *      p_tree,
+              bptree_node_t * p_parent,
+              size_t          index,
+              bptree_node_t * p_left,
+              bptree_node_t * p_right)
+{
+    size_t key_size = p_tree->key_size;
+    size_t start    = p_left->num_keys;
+
+    if (p_left->b_leaf)
+    {
+        p_left->p_next = p_right->p_next;
+    }
+    else
+    {
+        // The separator comes down between the two halves
+        memcpy(bptree_key(p_tree, p_left, start),
+               bptree_key(p_tree, p_parent, index),
+               key_size);
+        start++;
+    }
+
+    memcpy(bptree_key(p_tree, p_left, start),
+           bptree_key(p_tree, p_right, 0),
+           p_right->num_keys * key_size);
+    memcpy(&p_left->p_slots[start],
+           &p_right->p_slots[0],
+           (p_right->num_keys + !p_right->b_leaf) * sizeof(void *));
+    p_left->num_keys = start + p_right->num_keys;
+
+    free(p_right);
+
+    memmove(bptree_key(p_tree, p_parent, index),
+            bptree_key(p_tree, p_parent, index + 1),
+            (p_parent->num_keys - index - 1) * key_size);
+    memmove(&p_parent->p_slots[index + 1],
+            &p_parent->p_slots[index + 2],
+            (p_parent->num_keys - index - 1) * sizeof(void *));
+    p_parent->num_keys--;
+}
+
+bptree_t *
+bptree_create (size_t key_size,
+               int (*p_compare)(void *, void *),
+               void (*p_destroy)(void *))
+{
+    bptree_t * p_tree = NULL;
+
+    if ((0 == key_size) || (NULL == p_compare))
+    {
+        fprintf(stderr, "B+tree needs a key size and comparison function.\n");
+        goto EXIT;
+    }
+
+    if (((SIZE_MAX - sizeof(bptree_node_t)) / BPTREE_MAX_KEYS) < key_size)
+    {
+        fprintf(stderr, "B+tree key size is too large.\n");
+        goto EXIT;
+    }
+
+    p_tree = calloc(1, sizeof(bptree_t));
+
+    if (NULL == p_tree)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    p_tree->p_scratch = malloc(DOUBLE * key_size);
+
+    if (NULL == p_tree->p_scratch)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        free(p_tree);
+        p_tree = NULL;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_init(&p_tree->tree_lock, NULL))
+    {
+        fprintf(stderr, "B+tree lock initialization failed.\n");
+        free(p_tree->p_scratch);
+        free(p_tree);
+        p_tree = NULL;
+        goto EXIT;
+    }
+
+    p_tree->p_root             = NULL;
+    p_tree->key_size           = key_size;
+    p_tree->node_size = sizeof(bptree_node_t) + (BPTREE_MAX_KEYS * key_size);
+    p_tree->size      = 0;
+    p_tree->p_compare = p_compare;
+    p_tree->p_destroy_function = p_destroy;
+
+EXIT:
+    return p_tree;
+}
+
+void
+bptree_destroy (bptree_t * p_tree)
+{
+    if (NULL == p_tree)
+    {
+        goto EXIT;
+    }
+
+    pthread_rwlock_wrlock(&p_tree->tree_lock);
+
+    if (NULL != p_tree->p_root)
+    {
+        bptree_node_destroy(p_tree, p_tree->p_root);
+        p_tree->p_root = NULL;
+    }
+
+    free(p_tree->p_scratch);
+    p_tree->p_scratch = NULL;
+
+    pthread_rwlock_unlock(&p_tree->tree_lock);
+    pthread_rwlock_destroy(&p_tree->tree_lock);
+
+    free(p_tree);
+    p_tree = NULL;
+
+EXIT:
+    return;
+}
+
+int
+bptree_insert (bptree_t * p_tree, void * p_key, void * p_value)
+{
+    int             status = SUCCESS;
+    bptree_node_t * p_path[BPTREE_MAX_HEIGHT];
+    size_t          path_index[BPTREE_MAX_HEIGHT];
+    bptree_node_t * p_spare[BPTREE_MAX_HEIGHT + 1];
+    size_t          depth     = 0;
+    size_t          num_spare = 0;
+    bptree_node_t * p_node    = NULL;
+
+    if ((NULL == p_tree) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_wrlock(&p_tree->tree_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (NULL == p_tree->p_root)
+    {
+        p_tree->p_root = bptree_node_create(p_tree);
+
+        if (NULL == p_tree->p_root)
+        {
+            status = FAILURE;
+            goto EXIT_UNLOCK;
+        }
+
+        p_tree->p_root->b_leaf = true;
+    }
+
+    p_node = p_tree->p_root;
+
+    while (!p_node->b_leaf)
+    {
+        path_index[depth] = bptree_upper_bound(p_tree, p_node, p_key);
+        p_path[depth]     = p_node;
+        p_node            = p_node->p_slots[path_index[depth]];
+        depth++;
+    }
+
+    size_t index = bptree_lower_bound(p_tree, p_node, p_key);
+
+    if ((index < p_node->num_keys)
+        && (0
+            == p_tree->p_compare(bptree_key(p_tree, p_node, index), p_key)))
+    {
+        fprintf(stderr,
+                "Key already exists in B+tree. Keys must be distinct.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    if (BPTREE_MAX_KEYS > p_node->num_keys)
+    {
+        bptree_leaf_insert(p_tree, p_node, index, p_key, p_value);
+        goto EXIT_INSERTED;
+    }
+
+    // Allocate every node the split needs up front, so a failed allocation
+    // leaves the tree untouched: one per full node from the leaf up, plus a
+    // new root if the split reaches the old one
+    size_t num_splits = 1;
+
+    while ((num_splits <= depth)
+           && (BPTREE_MAX_KEYS == p_path[depth - num_splits]->num_keys))
+    {
+        num_splits++;
+    }
+
+    size_t num_needed = num_splits + (num_splits > depth);
+
+    for (num_spare = 0; num_spare < num_needed; num_spare++)
+    {
+        p_spare[num_spare] = bptree_node_create(p_tree);
+
+        if (NULL == p_spare[num_spare])
+        {
+            while (0 < num_spare)
+            {
+                num_spare--;
+                free(p_spare[num_spare]);
+            }
+
+            status = FAILURE;
+            goto EXIT_UNLOCK;
+        }
+    }
+
+    uint8_t *       p_carry = p_tree->p_scratch;
+    uint8_t *       p_up    = p_tree->p_scratch + p_tree->key_size;
+    bptree_node_t * p_right = p_spare[--num_spare];
+
+    bptree_split_leaf(p_tree, p_node, p_right, index, p_key, p_value);
+    memcpy(p_carry, bptree_key(p_tree, p_right, 0), p_tree->key_size);
+
+    while (NULL != p_right)
+    {
+        if (0 == depth)
+        {
+            bptree_node_t * p_root = p_spare[--num_spare];
+
+            p_root->b_leaf     = false;
+            p_root->num_keys   = 1;
+            p_root->p_slots[0] = p_tree->p_root;
+            p_root->p_slots[1] = p_right;
+            memcpy(bptree_key(p_tree, p_root, 0), p_carry, p_tree->key_size);
+            p_tree->p_root = p_root;
+            break;
+        }
+
+        depth--;
+        p_node = p_path[depth];
+
+        if (BPTREE_MAX_KEYS > p_node->num_keys)
+        {
+            bptree_internal_insert(
+                p_tree, p_node, path_index[depth], p_carry, p_right);
+            break;
+        }
+
+        bptree_node_t * p_sibling = p_spare[--num_spare];
+        uint8_t *       p_swap    = p_carry;
+
+        bptree_split_internal(p_tree,
+                              p_node,
+                              p_sibling,
+                              path_index[depth],
+                              p_carry,
+                              p_right,
+                              p_up);
+        p_right = p_sibling;
+        p_carry = p_up;
+        p_up    = p_swap;
+    }
+
+EXIT_INSERTED:
+    p_tree->size++;
+
+EXIT_UNLOCK:
+    pthread_rwlock_unlock(&p_tree->tree_lock);
+
+EXIT:
+    return status;
+}
+
+int
+bptree_find (bptree_t * p_tree, void * p_key, void ** pp_value)
+{
+    int status = FAILURE;
+
+    if ((NULL == p_tree) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_rdlock(&p_tree->tree_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    bptree_node_t * p_node = p_tree->p_root;
+
+    while ((NULL != p_node) && !p_node->b_leaf)
+    {
+        p_node = p_node->p_slots[bptree_upper_bound(p_tree, p_node, p_key)];
+    }
+
+    if (NULL != p_node)
+    {
+        size_t index = bptree_lower_bound(p_tree, p_node, p_key);
+
+        if ((index < p_node->num_keys)
+            && (0
+                == p_tree->p_compare(bptree_key(p_tree, p_node, index),
+                                     p_key)))
+        {
+            if (NULL != pp_value)
+            {
+                *pp_value = p_node->p_slots[index];
+            }
+
+            status = SUCCESS;
+        }
+    }
+
+    pthread_rwlock_unlock(&p_tree->tree_lock);
+
+EXIT:
+    return status;
+}
+
+int
+bptree_remove (bptree_t * p_tree, void * p_key)
+{
+    int             status = SUCCESS;
+    bptree_node_t * p_path[BPTREE_MAX_HEIGHT];
+    size_t          path_index[BPTREE_MAX_HEIGHT];
+    size_t          depth  = 0;
+    bptree_node_t * p_node = NULL;
+
+    if ((NULL == p_tree) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_wrlock(&p_tree->tree_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_node = p_tree->p_root;
+
+    while ((NULL != p_node) && !p_node->b_leaf)
+    {
+        path_index[depth] = bptree_upper_bound(p_tree, p_node, p_key);
+        p_path[depth]     = p_node;
+        p_node            = p_node->p_slots[path_index[depth]];
+        depth++;
+    }
+
+    size_t index = 0;
+
+    if (NULL != p_node)
+    {
+        index = bptree_lower_bound(p_tree, p_node, p_key);
+    }
+
+    if ((NULL == p_node) || (index == p_node->num_keys)
+        || (0 != p_tree->p_compare(bptree_key(p_tree, p_node, index), p_key)))
+    {
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    if (NULL != p_tree->p_destroy_function)
+    {
+        p_tree->p_destroy_function(p_node->p_slots[index]);
+    }
+
+    p_node->num_keys--;
+    memmove(bptree_key(p_tree, p_node, index),
+            bptree_key(p_tree, p_node, index + 1),
+            (p_node->num_keys - index) * p_tree->key_size);
+    memmove(&p_node->p_slots[index],
+            &p_node->p_slots[index + 1],
+            (p_node->num_keys - index) * sizeof(void *));
+    p_tree->size--;
+
+    // Refill underfull nodes from a sibling with keys to spare, or merge
+    // them with one; a merge takes a key from the parent, which may then
+    // underflow in turn
+    while ((0 < depth) && (BPTREE_MIN_KEYS > p_node->num_keys))
+    {
+        depth--;
+
+        bptree_node_t * p_parent = p_path[depth];
+        size_t          child    = path_index[depth];
+        bptree_node_t * p_left   = NULL;
+        bptree_node_t * p_right  = NULL;
+
+        if (0 < child)
+        {
+            p_left = p_parent->p_slots[child - 1];
+        }
+
+        if (child < p_parent->num_keys)
+        {
+            p_right = p_parent->p_slots[child + 1];
+        }
+
+        if ((NULL != p_left) && (BPTREE_MIN_KEYS < p_left->num_keys))
+        {
+            bptree_borrow_left(p_tree, p_parent, child, p_left, p_node);
+            break;
+        }
+
+        if ((NULL != p_right) && (BPTREE_MIN_KEYS < p_right->num_keys))
+        {
+            bptree_borrow_right(p_tree, p_parent, child, p_node, p_right);
+            break;
+        }
+
+        if (NULL != p_left)
+        {
+            bptree_merge(p_tree, p_parent, child - 1, p_left, p_node);
+        }
+        else
+        {
+            bptree_merge(p_tree, p_parent, child, p_node, p_right);
+        }
+
+        p_node = p_parent;
+    }
+
+    bptree_node_t * p_root = p_tree->p_root;
+
+    if (0 == p_root->num_keys)
+    {
+        p_tree->p_root = p_root->b_leaf ? NULL : p_root->p_slots[0];
+        free(p_root);
+    }
+
+EXIT_UNLOCK:
+    pthread_rwlock_unlock(&p_tree->tree_lock);
+
+EXIT:
+    return status;
+}
+
+int
+bptree_range (bptree_t * p_tree,
+              void *     p_low,
+              void *     p_high,
+              bool (*p_visit)(void * p_key, void * p_value, void * p_context),
+              void * p_context)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_tree) || (NULL == p_visit))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_rdlock(&p_tree->tree_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    bptree_node_t * p_node = p_tree->p_root;
+    size_t          index  = 0;
+
+    while ((NULL != p_node) && !p_node->b_leaf)
+    {
+        index = 0;
+
+        if (NULL != p_low)
+        {
+            index = bptree_upper_bound(p_tree, p_node, p_low);
+        }
+
+        p_node = p_node->p_slots[index];
+    }
+
+    index = 0;
+
+    if ((NULL != p_node) && (NULL != p_low))
+    {
+        index = bptree_lower_bound(p_tree, p_node, p_low);
+    }
+
+    for (; NULL != p_node; p_node = p_node->p_next, index = 0)
+    {
+        for (; index < p_node->num_keys; index++)
+        {
+            uint8_t * p_key = bptree_key(p_tree, p_node, index);
+
+            if (((NULL != p_high) && (0 < p_tree->p_compare(p_key, p_high)))
+                || !p_visit(p_key, p_node->p_slots[index], p_context))
+            {
+                goto EXIT_UNLOCK;
+            }
+        }
+    }
+
+EXIT_UNLOCK:
+    pthread_rwlock_unlock(&p_tree->tree_lock);
+
+EXIT:
+    return status;
+}
+
+size_t
+bptree_size (bptree_t * p_tree)
+{
+    size_t size = 0;
+
+    if ((NULL != p_tree) && (0 == pthread_rwlock_rdlock(&p_tree->tree_lock)))
+    {
+        size = p_tree->size;
+        pthread_rwlock_unlock(&p_tree->tree_lock);
+    }
+
+    return size;
+}
+
+// End of bptree.c
@@ -0,0 +1,181 @@
+/**
+ * @file bptree.h
+ * @brief Defines a B+tree ordered map whose wide nodes keep keys inline, so a
+ * lookup touches a few cache lines per level instead of one node per key.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef BPTREE_H
+#define BPTREE_H
+
+#include "common.h"
+
+/**
+ * @brief Defines the number of keys a node holds when full. The keys start on
+ * a cache line, so with 8-byte keys they span four lines and a binary search
+ * over them reads at most three of those lines.
+ *
+ */
+#define BPTREE_MAX_KEYS 32
+
+/**
+ * @brief Defines the fewest keys a node other than the root holds
+ *
+ */
+#define BPTREE_MIN_KEYS (BPTREE_MAX_KEYS / 2)
+
+/**
+ * @brief Defines the deepest tree the operations can walk. Every internal
+ * node below the root has at least BPTREE_MIN_KEYS + 1 children, so 16
+ * levels hold more keys than a size_t can count.
+ *
+ */
+#define BPTREE_MAX_HEIGHT 16
+
+/**
+ * @brief Defines the alignment of every node, so that a node starts on a
+ * cache line
+ *
+ */
+#define BPTREE_NODE_ALIGNMENT 64
+
+/**
+ * @brief A node of the tree.
+ *
+ * An internal node with num_keys keys has num_keys + 1 children; child i
+ * holds the keys ordered at or after key i - 1 and before key i. A leaf holds
+ * one value per key, and the leaves are linked in key order for range scans.
+ * The keys themselves follow the structure, key_size bytes each, starting at
+ * the first cache line boundary after p_slots so that no line of keys is
+ * shared with the header.
+ *
+ */
+typedef struct bptree_node_t
+{
+    size_t num_keys; /**< Number of keys in the node */
+    bool   b_leaf;   /**< Whether p_slots holds values rather than children */
+    struct bptree_node_t * p_next; /**< Next leaf in key order, or NULL */
+    void * p_slots[BPTREE_MAX_KEYS + 1]; /**< Children, or values of a leaf */
+    _Alignas(BPTREE_NODE_ALIGNMENT) uint8_t
+        keys[]; /**< BPTREE_MAX_KEYS keys of key_size bytes each */
+} bptree_node_t;
+
+/**
+ * @brief Structure representing a B+tree ordered map.
+ *
+ * The comparison function is stored once here rather than in every node.
+ * Writers take tree_lock for writing and readers for reading.
+ *
+ */
+typedef struct bptree_t
+{
+    pthread_rwlock_t tree_lock; /**< Read-write lock for thread-safe access
+                                     to the tree. */
+    bptree_node_t * p_root;    /**< Root node, or NULL when empty */
+    size_t          key_size;  /**< Size in bytes of each key */
+    size_t          node_size; /**< Size in bytes of each node */
+    size_t          size;      /**< Number of keys in the tree */
+    uint8_t *       p_scratch; /**< Room for the two keys a split carries */
+    int (*p_compare)(void *, void *); /**< Pointer to the key ordering
+                                           function */
+    void (*p_destroy_function)(
+        void *); /**< Pointer to the function used to destroy values */
+} bptree_t;
+
+/**
+ * @brief Create an empty tree of keys of key_size bytes, copied into the
+ * tree on insertion.
+ *
+ * @param key_size Size in bytes of one key.
+ * @param p_compare Ordering function for keys: negative, zero or positive as
+ * its first argument sorts before, with, or after its second.
+ * @param p_destroy Function used to destroy values on removal and at
+ * destroy, or NULL.
+ * @return A pointer to the newly created tree, or NULL if creation fails.
+ * @warning Returns NULL in the event of memory allocation failure, lock
+ * initialization failure, a key_size of 0, or a NULL p_compare.
+ */
+bptree_t * bptree_create (size_t key_size,
+                          int (*p_compare)(void *, void *),
+                          void (*p_destroy)(void *));
+
+/**
+ * @brief Destroys every value and frees the tree.
+ *
+ * @param p_tree A pointer to the tree.
+ */
+void bptree_destroy (bptree_t * p_tree);
+
+/**
+ * @brief Insert a copy of the key at p_key, mapped to p_value.
+ *
+ * @param p_tree Pointer to the tree.
+ * @param p_key Pointer to key_size bytes of key.
+ * @param p_value The value stored for the key.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * memory allocation failure, or a key already in the tree. Keys must be
+ * distinct.
+ */
+int bptree_insert (bptree_t * p_tree, void * p_key, void * p_value);
+
+/**
+ * @brief Look up the value stored for a key.
+ *
+ * @param p_tree Pointer to the tree.
+ * @param p_key Pointer to the key to look up.
+ * @param pp_value Receives the value, may be NULL to test membership.
+ * @return SUCCESS if the key is present, FAILURE otherwise.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or a key not in the tree.
+ */
+int bptree_find (bptree_t * p_tree, void * p_key, void ** pp_value);
+
+/**
+ * @brief Remove a key and destroy its value.
+ *
+ * @param p_tree Pointer to the tree.
+ * @param p_key Pointer to the key to remove.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or a key not in the tree.
+ */
+int bptree_remove (bptree_t * p_tree, void * p_key);
+
+/**
+ * @brief Call p_visit on every key from p_low to p_high inclusive, in
+ * ascending order, under one read lock. The scan finds the first leaf and
+ * then follows the leaf links.
+ *
+ * @param p_tree Pointer to the tree.
+ * @param p_low Pointer to the lowest key to visit, or NULL to start at the
+ * smallest key.
+ * @param p_high Pointer to the highest key to visit, or NULL to end at the
+ * largest key.
+ * @param p_visit Function receiving each key, its value and p_context.
+ * Returning false stops the scan.
+ * @param p_context Argument passed to every call.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or lock
+ * failure. p_visit must not write to the tree.
+ */
+int bptree_range (bptree_t * p_tree,
+                  void *     p_low,
+                  void *     p_high,
+                  bool (*p_visit)(void * p_key,
+                                  void * p_value,
+                                  void * p_context),
+                  void * p_context);
+
+/**
+ * @brief Get the number of keys in the tree.
+ *
+ * @param p_tree Pointer to the tree.
+ * @return The number of keys, or 0 if p_tree is NULL.
+ */
+size_t bptree_size (bptree_t * p_tree);
+
+#endif /* BPTREE_H */
+
+// End of bptree.h
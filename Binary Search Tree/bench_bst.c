@@ -0,0 +1,286 @@
+/*
+ * Benchmark of the AVL tree, its node arena and its bulk builders.
+ *
+ * Every round uses the same keys, 0 to n - 1, first in ascending order and
+ * then shuffled with a fixed seed, and prints the time and the height of the
+ * tree it built:
+ * - insert() one key at a time into a heap tree, then free_bst(): sorted
+ *   input must not degenerate, so both orders end near log2(n) levels.
+ * - bst_insert() into a heap tree and into an arena tree, then
+ *   bst_destroy(): the arena allocates in blocks and frees without a walk.
+ * - bst_build_sorted() on the ascending keys and bst_build() on the shuffled
+ *   ones, against the insert loops above.
+ *
+ * bst.c carries a demonstration main, so it is compiled under another name:
+ *
+ *   cc -O2 -pthread -I../Threadpool -Dmain=bst_demo_main -c bst.c
+ *   cc -O2 -pthread -I../Threadpool bench_bst.c bst.o \
+ *       ../Threadpool/parallel_sort.c ../Threadpool/taskgraph.c \
+ *       ../Threadpool/threadpool.c -lssl -lcrypto
+ *
+ * Usage: ./a.out [keys] [sort threads]
+ * With 0 sort threads, the default, bst_build() sorts on the calling thread.
+ */
+
+#define _GNU_SOURCE
+#include "bst.h"
+#include "threadpool.h"
+#include <time.h>
+
+#define BENCH_DEFAULT_KEYS 1000000
+#define BENCH_SEED         0x9E3779B97F4A7C15u
+
+static double
+bench_now_ms (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((double)now.tv_sec * 1e3) + ((double)now.tv_nsec / 1e6);
+}
+
+static int
+bench_compare (void * p_left, void * p_right)
+{
+    long left  = *(long *)p_left;
+    long right = *(long *)p_right;
+
+    return (left > right) - (left < right);
+}
+
+static int
+bench_height (node_t * p_root)
+{
+    return (NULL == p_root) ? 0 : p_root->height;
+}
+
+/*
+ * Fisher-Yates shuffle driven by xorshift64, so that every run inserts the
+ * keys in the same order.
+ */
+static void
+bench_shuffle (void ** pp_values, size_t count)
+{
+    uint64_t state = BENCH_SEED;
+
+    for (size_t index = count; index > 1; index--)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        size_t other   = (size_t)(state % index);
+        void * p_value = pp_values[index - 1];
+
+        pp_values[index - 1] = pp_values[other];
+        pp_values[other]     = p_value;
+    }
+}
+
+/*
+ * Builds a heap tree with insert(), then frees it with free_bst().
+ */
+static void
+bench_insert (const char * p_label, void ** pp_values, size_t count)
+{
+    node_t * p_root = NULL;
+    double   start  = bench_now_ms();
+
+    for (size_t index = 0; index < count; index++)
+    {
+        p_root = insert(p_root, pp_values[index], bench_compare);
+    }
+
+    double built  = bench_now_ms();
+    int    height = bench_height(p_root);
+
+    free_bst(p_root);
+
+    double freed = bench_now_ms();
+
+    printf("%-16s heap  %-8s %9.1f ms, height %3d, free %8.2f ms\n",
+           "insert",
+           p_label,
+           built - start,
+           height,
+           freed - built);
+}
+
+/*
+ * Builds a tree through the handle with bst_insert(), then destroys it.
+ */
+static int
+bench_handle (const char * p_label,
+              void **      pp_values,
+              size_t       count,
+              bool         b_arena)
+{
+    int     status = 0;
+    bst_t * p_tree = bst_create(bench_compare, b_arena);
+
+    if (NULL == p_tree)
+    {
+        fprintf(stderr, "Benchmark setup failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    double start = bench_now_ms();
+
+    for (size_t index = 0; index < count; index++)
+    {
+        bst_insert(p_tree, pp_values[index]);
+    }
+
+    double built  = bench_now_ms();
+    int    height = bench_height(p_tree->p_root);
+
+    bst_destroy(p_tree);
+
+    double freed = bench_now_ms();
+
+    printf("%-16s %-5s %-8s %9.1f ms, height %3d, free %8.2f ms\n",
+           "bst_insert",
+           b_arena ? "arena" : "heap",
+           p_label,
+           built - start,
+           height,
+           freed - built);
+
+EXIT:
+    return status;
+}
+
+/*
+ * Builds an arena tree with bst_build_sorted(), or with bst_build() when
+ * b_sort is set, then destroys it.
+ */
+static int
+bench_build (void **        pp_values,
+             size_t         count,
+             bool           b_sort,
+             threadpool_t * p_pool)
+{
+    int     status = 0;
+    bst_t * p_tree = bst_create(bench_compare, true);
+
+    if (NULL == p_tree)
+    {
+        fprintf(stderr, "Benchmark setup failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    double start = bench_now_ms();
+
+    if (b_sort)
+    {
+        status = bst_build(p_tree, pp_values, count, p_pool);
+    }
+    else
+    {
+        status = bst_build_sorted(p_tree, pp_values, count);
+    }
+
+    double built = bench_now_ms();
+
+    if (0 != status)
+    {
+        fprintf(stderr, "Bulk build failure.\n");
+    }
+    else
+    {
+        printf("%-16s arena %-8s %9.1f ms, height %3d\n",
+               b_sort ? "bst_build" : "bst_build_sorted",
+               b_sort ? "shuffled" : "sorted",
+               built - start,
+               bench_height(p_tree->p_root));
+    }
+
+    bst_destroy(p_tree);
+
+EXIT:
+    return status;
+}
+
+int
+main (int argc, char ** argv)
+{
+    int            status      = 0;
+    long           num_keys    = BENCH_DEFAULT_KEYS;
+    long           num_threads = 0;
+    long *         p_keys      = NULL;
+    void **        pp_values   = NULL;
+    threadpool_t * p_pool      = NULL;
+
+    if (1 < argc)
+    {
+        num_keys = strtol(argv[1], NULL, 10);
+    }
+
+    if (2 < argc)
+    {
+        num_threads = strtol(argv[2], NULL, 10);
+    }
+
+    if ((0 >= num_keys) || (0 > num_threads))
+    {
+        fprintf(stderr, "Usage: %s [keys] [sort threads]\n", argv[0]);
+        status = 1;
+        goto EXIT;
+    }
+
+    p_keys    = malloc((size_t)num_keys * sizeof(long));
+    pp_values = malloc((size_t)num_keys * sizeof(void *));
+
+    if (0 < num_threads)
+    {
+        p_pool = threadpool_init((int)num_threads);
+    }
+
+    if ((NULL == p_keys) || (NULL == pp_values)
+        || ((0 < num_threads) && (NULL == p_pool)))
+    {
+        fprintf(stderr, "Benchmark setup failure.\n");
+        status = 1;
+        goto EXIT;
+    }
+
+    for (long index = 0; index < num_keys; index++)
+    {
+        p_keys[index]    = index;
+        pp_values[index] = &p_keys[index];
+    }
+
+    printf("%ld keys\n", num_keys);
+
+    bench_insert("sorted", pp_values, (size_t)num_keys);
+
+    if ((0 != bench_handle("sorted", pp_values, (size_t)num_keys, false))
+        || (0 != bench_handle("sorted", pp_values, (size_t)num_keys, true))
+        || (0 != bench_build(pp_values, (size_t)num_keys, false, NULL)))
+    {
+        status = 1;
+        goto EXIT;
+    }
+
+    bench_shuffle(pp_values, (size_t)num_keys);
+    bench_insert("shuffled", pp_values, (size_t)num_keys);
+
+    if ((0 != bench_handle("shuffled", pp_values, (size_t)num_keys, false))
+        || (0 != bench_handle("shuffled", pp_values, (size_t)num_keys, true))
+        || (0 != bench_build(pp_values, (size_t)num_keys, true, p_pool)))
+    {
+        status = 1;
+    }
+
+EXIT:
+    threadpool_destroy(p_pool);
+    free(pp_values);
+    free(p_keys);
+
+    return status;
+}
+
+// End of bench_bst.c
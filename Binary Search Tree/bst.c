@@ -1,4 +1,6 @@
+#define _GNU_SOURCE
 #include "bst.h"
+#include "parallel_sort.h"
 
 void
 trunk_show (trunk_t * p_trunk)
@@ -20,28 +22,26 @@ tree_print (node_t * p_node, trunk_t * p_prev, int is_left)
         return;
     }
 
-    char *    prev_str = "    ";
-    trunk_t * trunk    = malloc(sizeof(trunk_t));
-    trunk->prev        = p_prev;
-    trunk->str         = prev_str;
-    tree_print(p_node->p_right, trunk, 1);
+    char *  prev_str = "    ";
+    trunk_t trunk    = { p_prev, prev_str };
+    tree_print(p_node->p_right, &trunk, 1);
 
     if (!p_prev)
     {
-        trunk->str = "───";
+        trunk.str = "───";
     }
     else if (is_left)
     {
-        trunk->str = "┌───";
-        prev_str   = "   │";
+        trunk.str = "┌───";
+        prev_str  = "   │";
     }
     else
     {
-        trunk->str  = "└───";
+        trunk.str   = "└───";
         p_prev->str = prev_str;
     }
 
-    trunk_show(trunk);
+    trunk_show(&trunk);
     printf("%d\n", *((int *)(p_node->p_value)));
 
     if (p_prev)
@@ -49,9 +49,8 @@ tree_print (node_t * p_node, trunk_t * p_prev, int is_left)
         p_prev->str = prev_str;
     }
 
-    trunk->str = "   │";
-    tree_print(p_node->p_left, trunk, 0);
-    free(trunk);
+    trunk.str = "   │";
+    tree_print(p_node->p_left, &trunk, 0);
 }
 
 node_t *
@@ -77,81 +76,329 @@ create_node (void * value, int (*p_compare)(void *, void *))
         p_node->p_left    = NULL;
         p_node->p_right   = NULL;
         p_node->p_compare = p_compare;
+        p_node->height    = 1;
+        p_node->size      = 1;
     }
 
 EXIT:
     return p_node;
 }
 
-node_t *
-insert (node_t * p_node, void * p_value, int (*p_compare)(void *, void *))
+/**
+ * @brief Takes a node from the arena: a released node if there is one, else
+ * the next unused node of the newest block, else a new block twice the size
+ * of the last, up to BST_ARENA_MAX_BLOCK nodes.
+ */
+static node_t *
+bst_arena_alloc (bst_arena_t * p_arena)
 {
-    node_t * p_return = NULL;
+    node_t *            p_node  = p_arena->p_free;
+    bst_arena_block_t * p_block = p_arena->p_blocks;
 
-    if (NULL == p_node)
+    if (NULL != p_node)
+    {
+        p_arena->p_free = p_node->p_left;
+        goto EXIT;
+    }
+
+    if ((NULL == p_block) || (p_block->used == p_block->capacity))
     {
-        p_return = create_node(p_value, p_compare);
+        size_t capacity = BST_ARENA_FIRST_BLOCK;
 
-        if (NULL == p_return)
+        if (NULL != p_block)
+        {
+            capacity = p_block->capacity * 2;
+        }
+
+        if (BST_ARENA_MAX_BLOCK < capacity)
+        {
+            capacity = BST_ARENA_MAX_BLOCK;
+        }
+
+        p_block = malloc(sizeof(bst_arena_block_t)
+                         + (capacity * sizeof(node_t)));
+
+        if (NULL == p_block)
         {
             goto EXIT;
         }
+
+        p_block->p_next   = p_arena->p_blocks;
+        p_block->capacity = capacity;
+        p_block->used     = 0;
+        p_arena->p_blocks = p_block;
+    }
+
+    p_node = &p_block->nodes[p_block->used];
+    p_block->used++;
+
+EXIT:
+    return p_node;
+}
+
+/**
+ * @brief Frees every block of the arena, and with them every node ever taken
+ * from it, in one pass over the blocks.
+ */
+static void
+bst_arena_release (bst_arena_t * p_arena)
+{
+    while (NULL != p_arena->p_blocks)
+    {
+        bst_arena_block_t * p_next = p_arena->p_blocks->p_next;
+
+        free(p_arena->p_blocks);
+        p_arena->p_blocks = p_next;
+    }
+
+    p_arena->p_free = NULL;
+}
+
+/**
+ * @brief Creates a node from p_arena, or with create_node() if it is NULL.
+ */
+static node_t *
+bst_node_alloc (bst_arena_t * p_arena,
+                void *        p_value,
+                int (*p_compare)(void *, void *))
+{
+    node_t * p_node = NULL;
+
+    if (NULL == p_arena)
+    {
+        p_node = create_node(p_value, p_compare);
+        goto EXIT;
+    }
+
+    p_node = bst_arena_alloc(p_arena);
+
+    if (NULL == p_node)
+    {
+        fprintf(stderr, "Error: Memory not allocated!\n");
+        goto EXIT;
+    }
+
+    p_node->p_value   = p_value;
+    p_node->p_compare = p_compare;
+    p_node->p_left    = NULL;
+    p_node->p_right   = NULL;
+    p_node->height    = 1;
+    p_node->size      = 1;
+
+EXIT:
+    return p_node;
+}
+
+/**
+ * @brief Returns a node to p_arena's free list, or frees it if p_arena is
+ * NULL.
+ */
+static void
+bst_node_release (bst_arena_t * p_arena, node_t * p_node)
+{
+    if (NULL == p_arena)
+    {
+        free(p_node);
     }
     else
     {
+        p_node->p_left  = p_arena->p_free;
+        p_arena->p_free = p_node;
+    }
+}
+
+static int
+node_height (node_t * p_node)
+{
+    return (NULL == p_node) ? 0 : p_node->height;
+}
+
+static size_t
+node_size (node_t * p_node)
+{
+    return (NULL == p_node) ? 0 : p_node->size;
+}
+
+/**
+ * @brief Recomputes the height and subtree size of p_node from its children.
+ */
+static void
+update_node (node_t * p_node)
+{
+    int left_height  = node_height(p_node->p_left);
+    int right_height = node_height(p_node->p_right);
+
+    p_node->height
+        = 1 + ((left_height > right_height) ? left_height : right_height);
+    p_node->size = 1 + node_size(p_node->p_left) + node_size(p_node->p_right);
+}
+
+static node_t *
+rotate_left (node_t * p_node)
+{
+    node_t * p_pivot = p_node->p_right;
+
+    p_node->p_right = p_pivot->p_left;
+    p_pivot->p_left = p_node;
+    update_node(p_node);
+    update_node(p_pivot);
+
+    return p_pivot;
+}
+
+static node_t *
+rotate_right (node_t * p_node)
+{
+    node_t * p_pivot = p_node->p_left;
+
+    p_node->p_left   = p_pivot->p_right;
+    p_pivot->p_right = p_node;
+    update_node(p_node);
+    update_node(p_pivot);
+
+    return p_pivot;
+}
 
-        int cmp_result = p_node->p_compare(p_node->p_value, p_value);
+/**
+ * @brief Restores the AVL property at p_node, whose subtrees are balanced and
+ * differ in height by at most two, and returns the root of the rebalanced
+ * subtree. Keeping every node's subtrees within one level of each other
+ * bounds the height, and so the recursion depth of every operation, by
+ * 1.44 log2(n) even when keys arrive in sorted order.
+ */
+static node_t *
+rebalance (node_t * p_node)
+{
+    int balance = node_height(p_node->p_left) - node_height(p_node->p_right);
 
-        if (cmp_result > 0)
+    if (1 < balance)
+    {
+        if (node_height(p_node->p_left->p_left)
+            < node_height(p_node->p_left->p_right))
         {
-            p_node->p_right = insert(p_node->p_right, p_value, p_compare);
-            p_return        = p_node;
+            p_node->p_left = rotate_left(p_node->p_left);
         }
-        else if (cmp_result < 0)
+
+        p_node = rotate_right(p_node);
+    }
+    else if (-1 > balance)
+    {
+        if (node_height(p_node->p_right->p_right)
+            < node_height(p_node->p_right->p_left))
         {
-            p_node->p_left = insert(p_node->p_left, p_value, p_compare);
-            p_return       = p_node;
+            p_node->p_right = rotate_right(p_node->p_right);
         }
-        else
+
+        p_node = rotate_left(p_node);
+    }
+    else
+    {
+        update_node(p_node);
+    }
+
+    return p_node;
+}
+
+/**
+ * @brief Walks back up the links in pp_path, deepest first, rebalancing each
+ * subtree. Once a subtree keeps the height it had before the update nothing
+ * above it needs rebalancing, so the rest of the path only has its subtree
+ * sizes refreshed.
+ */
+static void
+rebalance_path (node_t ** pp_path[], size_t depth)
+{
+    bool b_settled = false;
+
+    while (0 < depth)
+    {
+        depth--;
+
+        node_t ** pp_link = pp_path[depth];
+
+        if (b_settled)
+        {
+            (*pp_link)->size = 1 + node_size((*pp_link)->p_left)
+                               + node_size((*pp_link)->p_right);
+            continue;
+        }
+
+        int old_height = (*pp_link)->height;
+
+        *pp_link  = rebalance(*pp_link);
+        b_settled = (old_height == (*pp_link)->height);
+    }
+}
+
+/**
+ * @brief Inserts p_value below *pp_root, allocating from p_arena or the
+ * heap, and stores the new root. Returns 0 if a node was added, else -1.
+ */
+static int
+bst_insert_into (node_t **     pp_root,
+                 void *        p_value,
+                 int (*p_compare)(void *, void *),
+                 bst_arena_t * p_arena)
+{
+    int       status  = -1;
+    node_t ** pp_path[BST_MAX_HEIGHT];
+    size_t    depth   = 0;
+    node_t ** pp_link = pp_root;
+
+    while (NULL != *pp_link)
+    {
+        int cmp_result = (*pp_link)->p_compare((*pp_link)->p_value, p_value);
+
+        if (0 == cmp_result)
         {
             fprintf(stderr,
                     "Value already exists in BST. Keys must be distinct.\n");
+            goto EXIT;
         }
+
+        pp_path[depth] = pp_link;
+        depth++;
+        pp_link = (cmp_result > 0) ? &(*pp_link)->p_right
+                                   : &(*pp_link)->p_left;
+    }
+
+    *pp_link = bst_node_alloc(p_arena, p_value, p_compare);
+
+    if (NULL != *pp_link)
+    {
+        rebalance_path(pp_path, depth);
+        status = 0;
     }
 
 EXIT:
-    return p_return;
+    return status;
 }
 
 node_t *
-find (node_t * p_curr_node, void * p_val)
+insert (node_t * p_node, void * p_value, int (*p_compare)(void *, void *))
 {
-    node_t * p_temp = NULL;
+    bst_insert_into(&p_node, p_value, p_compare, NULL);
+
+    return p_node;
+}
 
-    if (NULL != p_curr_node)
+node_t *
+find (node_t * p_curr_node, void * p_val)
+{
+    while (NULL != p_curr_node)
     {
         int cmp_result = p_curr_node->p_compare(p_val, p_curr_node->p_value);
 
         if (0 == cmp_result)
         {
-            p_temp = p_curr_node;
+            break;
         }
-        else
-        {
-            if (cmp_result > 0)
-            {
-                p_temp = p_curr_node->p_left;
-            }
-            else
-            {
-                p_temp = p_curr_node->p_right;
-            }
 
-            p_temp = find(p_temp, p_val);
-        }
+        p_curr_node
+            = (cmp_result > 0) ? p_curr_node->p_left : p_curr_node->p_right;
     }
 
-    return p_temp;
+    return p_curr_node;
 }
 
 bool
@@ -216,118 +463,875 @@ get_min (node_t * p_root)
 {
     node_t * p_return = p_root;
 
-    if (NULL != p_root->p_left)
+    while ((NULL != p_return) && (NULL != p_return->p_left))
     {
-        p_return = get_min(p_root->p_left);
+        p_return = p_return->p_left;
     }
 
     return p_return;
 }
 
-node_t *
-delete_node (node_t * p_root, void * p_value)
+/**
+ * @brief Removes p_value from below *pp_root, returning its node to p_arena
+ * or the heap, and stores the new root. Returns 0 if a node was removed,
+ * else -1.
+ */
+static int
+bst_delete_from (node_t ** pp_root, void * p_value, bst_arena_t * p_arena)
 {
-    node_t * p_return = p_root;
+    int       status  = -1;
+    node_t ** pp_path[BST_MAX_HEIGHT];
+    size_t    depth   = 0;
+    node_t ** pp_link = pp_root;
 
-    if ((NULL == p_root) || (NULL == p_value))
+    if (NULL == p_value)
     {
-        p_return = NULL;
+        goto EXIT;
+    }
+
+    while (NULL != *pp_link)
+    {
+        int cmp_result = (*pp_link)->p_compare((*pp_link)->p_value, p_value);
+
+        if (0 == cmp_result)
+        {
+            break;
+        }
+
+        pp_path[depth] = pp_link;
+        depth++;
+        pp_link = (cmp_result > 0) ? &(*pp_link)->p_right
+                                   : &(*pp_link)->p_left;
+    }
+
+    node_t * p_victim = *pp_link;
+
+    if (NULL == p_victim)
+    {
+        goto EXIT;
+    }
+
+    if (is_leaf(p_victim) || is_only_child(p_victim))
+    {
+        *pp_link = has_only_left(p_victim) ? p_victim->p_left
+                                           : p_victim->p_right;
     }
     else
     {
+        // The node keeps its place and takes the value of get_min(p_right),
+        // whose own node is unlinked instead; it has no left child
+        node_t * p_node = p_victim;
+
+        pp_path[depth] = pp_link;
+        depth++;
+        pp_link = &p_node->p_right;
+
+        while (NULL != (*pp_link)->p_left)
+        {
+            pp_path[depth] = pp_link;
+            depth++;
+            pp_link = &(*pp_link)->p_left;
+        }
+
+        p_victim        = *pp_link;
+        p_node->p_value = p_victim->p_value;
+        *pp_link        = p_victim->p_right;
+    }
+
+    bst_node_release(p_arena, p_victim);
+    rebalance_path(pp_path, depth);
+    status = 0;
+
+EXIT:
+    return status;
+}
+
+node_t *
+delete_node (node_t * p_root, void * p_value)
+{
+    bst_delete_from(&p_root, p_value, NULL);
+
+    return p_root;
+}
 
-        int cmp_result = p_root->p_compare(p_root->p_value, p_value);
+void
+print_postorder (node_t * p_node)
+{
+    node_t * p_stack[BST_MAX_HEIGHT];
+    size_t   depth  = 0;
+    node_t * p_last = NULL;
 
-        if (0 < cmp_result)
+    while ((NULL != p_node) || (0 < depth))
+    {
+        if (NULL != p_node)
         {
-            p_root->p_left = delete_node(p_root->p_left, p_value);
+            p_stack[depth] = p_node;
+            depth++;
+            p_node = p_node->p_left;
+            continue;
         }
-        else if (0 > cmp_result)
+
+        node_t * p_top = p_stack[depth - 1];
+
+        if ((NULL != p_top->p_right) && (p_last != p_top->p_right))
         {
-            p_root->p_right = delete_node(p_root->p_right, p_value);
+            p_node = p_top->p_right;
         }
         else
         {
-
-            if (is_leaf(p_root))
-            {
-                p_return = NULL;
-                free(p_root);
-            }
-            else if (is_only_child(p_root))
-            {
-                p_return
-                    = has_only_left(p_root) ? p_root->p_left : p_root->p_right;
-                free(p_root);
-            }
-            else
-            {
-                node_t * p_min  = get_min(p_root->p_right);
-                p_root->p_value = p_min->p_value;
-                p_root->p_right = delete_node(p_root->p_right, p_min->p_value);
-            }
+            printf("%d ", *((int *)(p_top->p_value)));
+            p_last = p_top;
+            depth--;
         }
     }
 
-    return p_return;
+    printf("\n");
 }
 
 void
-print_postorder (node_t * p_node)
+print_inorder (node_t * p_node)
 {
-    if (p_node != NULL)
-    {
-        print_postorder(p_node->p_left);
-        print_preorder(p_node->p_right);
-        printf("%d ", *((int *)(p_node->p_value)));
-    }
-    else
+    bst_iterator_t iterator;
+    node_t *       p_next = NULL;
+
+    bst_iterator_init(&iterator, p_node);
+
+    while (NULL != (p_next = bst_iterator_next(&iterator)))
     {
-        printf("\n");
+        printf("%d ", *((int *)(p_next->p_value)));
     }
+
+    printf("\n");
 }
 
 void
-print_inorder (node_t * p_node)
+print_preorder (node_t * p_node)
 {
-    if (p_node != NULL)
+    node_t * p_stack[BST_MAX_HEIGHT + 1];
+    size_t   depth = 0;
+
+    if (NULL != p_node)
     {
-        print_inorder(p_node->p_left);
+        p_stack[depth] = p_node;
+        depth++;
+    }
+
+    while (0 < depth)
+    {
+        depth--;
+        p_node = p_stack[depth];
         printf("%d ", *((int *)(p_node->p_value)));
-        print_inorder(p_node->p_right);
+
+        if (NULL != p_node->p_right)
+        {
+            p_stack[depth] = p_node->p_right;
+            depth++;
+        }
+
+        if (NULL != p_node->p_left)
+        {
+            p_stack[depth] = p_node->p_left;
+            depth++;
+        }
     }
-    else
+
+    printf("\n");
+}
+
+/**
+ * @brief Releases every node below p_node to p_arena, or frees them if it is
+ * NULL.
+ */
+static void
+bst_free_nodes (bst_arena_t * p_arena, node_t * p_node)
+{
+    // Rotating each left child up flattens the tree into a right spine that
+    // is freed as it is walked, so no stack is needed at any depth
+    while (NULL != p_node)
     {
-        printf("\n");
+        node_t * p_next = p_node->p_left;
+
+        if (NULL != p_next)
+        {
+            p_node->p_left  = p_next->p_right;
+            p_next->p_right = p_node;
+        }
+        else
+        {
+            p_next = p_node->p_right;
+            bst_node_release(p_arena, p_node);
+        }
+
+        p_node = p_next;
     }
 }
 
 void
-print_preorder (node_t * p_node)
+free_bst (node_t * p_node)
+{
+    bst_free_nodes(NULL, p_node);
+}
+
+void
+bst_iterator_init (bst_iterator_t * p_iterator, node_t * p_root)
 {
-    if (p_node != NULL)
+    p_iterator->depth = 0;
+
+    while (NULL != p_root)
     {
-        printf("%d ", *((int *)(p_node->p_value)));
-        print_postorder(p_node->p_left);
-        print_preorder(p_node->p_right);
+        p_iterator->p_stack[p_iterator->depth] = p_root;
+        p_iterator->depth++;
+        p_root = p_root->p_left;
     }
-    else
+}
+
+node_t *
+bst_iterator_next (bst_iterator_t * p_iterator)
+{
+    node_t * p_return = NULL;
+
+    if (0 == p_iterator->depth)
+    {
+        goto EXIT;
+    }
+
+    p_iterator->depth--;
+    p_return = p_iterator->p_stack[p_iterator->depth];
+
+    for (node_t * p_node = p_return->p_right; NULL != p_node;
+         p_node          = p_node->p_left)
     {
-        printf("\n");
+        p_iterator->p_stack[p_iterator->depth] = p_node;
+        p_iterator->depth++;
     }
+
+EXIT:
+    return p_return;
 }
 
-void
-free_bst (node_t * p_node)
+node_t *
+bst_lower_bound (node_t * p_root, void * p_key)
 {
-    if (p_node == NULL)
+    node_t * p_return = NULL;
+
+    // Greater keys are stored to the left, so p_right leads to smaller keys
+    while (NULL != p_root)
     {
-        return;
+        if (0 <= p_root->p_compare(p_root->p_value, p_key))
+        {
+            p_return = p_root;
+            p_root   = p_root->p_right;
+        }
+        else
+        {
+            p_root = p_root->p_left;
+        }
     }
 
-    free_bst(p_node->p_left);
-    free_bst(p_node->p_right);
-    free(p_node);
+    return p_return;
+}
+
+node_t *
+bst_upper_bound (node_t * p_root, void * p_key)
+{
+    node_t * p_return = NULL;
+
+    while (NULL != p_root)
+    {
+        if (0 < p_root->p_compare(p_root->p_value, p_key))
+        {
+            p_return = p_root;
+            p_root   = p_root->p_right;
+        }
+        else
+        {
+            p_root = p_root->p_left;
+        }
+    }
+
+    return p_return;
+}
+
+node_t *
+bst_successor (node_t * p_root, node_t * p_node)
+{
+    node_t * p_return = NULL;
+
+    if (NULL != p_node)
+    {
+        p_return = bst_upper_bound(p_root, p_node->p_value);
+    }
+
+    return p_return;
+}
+
+node_t *
+bst_predecessor (node_t * p_root, node_t * p_node)
+{
+    node_t * p_return = NULL;
+
+    while ((NULL != p_root) && (NULL != p_node))
+    {
+        if (0 > p_root->p_compare(p_root->p_value, p_node->p_value))
+        {
+            p_return = p_root;
+            p_root   = p_root->p_left;
+        }
+        else
+        {
+            p_root = p_root->p_right;
+        }
+    }
+
+    return p_return;
+}
+
+void
+bst_cursor_seek (bst_cursor_t * p_cursor,
+                 node_t *       p_root,
+                 void *         p_from,
+                 bool           b_inclusive)
+{
+    p_cursor->depth = 0;
+
+    // Every node at or after p_from on the search path is still to come;
+    // the others, and the smaller subtrees hanging off them, are skipped
+    while (NULL != p_root)
+    {
+        int cmp_result = 1;
+
+        if (NULL != p_from)
+        {
+            cmp_result = p_root->p_compare(p_root->p_value, p_from);
+        }
+
+        if ((0 < cmp_result) || (b_inclusive && (0 == cmp_result)))
+        {
+            p_cursor->p_stack[p_cursor->depth] = p_root;
+            p_cursor->depth++;
+            p_root = p_root->p_right;
+        }
+        else
+        {
+            p_root = p_root->p_left;
+        }
+    }
+}
+
+node_t *
+bst_cursor_next (bst_cursor_t * p_cursor)
+{
+    node_t * p_return = NULL;
+
+    if (0 == p_cursor->depth)
+    {
+        goto EXIT;
+    }
+
+    p_cursor->depth--;
+    p_return = p_cursor->p_stack[p_cursor->depth];
+
+    for (node_t * p_node = p_return->p_left; NULL != p_node;
+         p_node          = p_node->p_right)
+    {
+        p_cursor->p_stack[p_cursor->depth] = p_node;
+        p_cursor->depth++;
+    }
+
+EXIT:
+    return p_return;
+}
+
+size_t
+bst_range (node_t * p_root,
+           void *   p_low,
+           void *   p_high,
+           bool (*p_visit)(void * p_value, void * p_context),
+           void * p_context)
+{
+    size_t       num_visited = 0;
+    bst_cursor_t cursor;
+    node_t *     p_node = NULL;
+
+    if (NULL == p_visit)
+    {
+        goto EXIT;
+    }
+
+    bst_cursor_seek(&cursor, p_root, p_low, true);
+
+    while (NULL != (p_node = bst_cursor_next(&cursor)))
+    {
+        if ((NULL != p_high)
+            && (0 < p_node->p_compare(p_node->p_value, p_high)))
+        {
+            break;
+        }
+
+        num_visited++;
+
+        if (!p_visit(p_node->p_value, p_context))
+        {
+            break;
+        }
+    }
+
+EXIT:
+    return num_visited;
+}
+
+bst_t *
+bst_create (int (*p_compare)(void *, void *), bool b_arena)
+{
+    bst_t * p_tree = NULL;
+
+    if (NULL == p_compare)
+    {
+        fprintf(stderr, "NULL comparison function pointer provided.\n");
+        goto EXIT;
+    }
+
+    p_tree = calloc(1, sizeof(bst_t));
+
+    if (NULL == p_tree)
+    {
+        fprintf(stderr, "Error: Memory not allocated!\n");
+        goto EXIT;
+    }
+
+    p_tree->p_root         = NULL;
+    p_tree->p_compare      = p_compare;
+    p_tree->b_arena        = b_arena;
+    p_tree->arena.p_blocks = NULL;
+    p_tree->arena.p_free   = NULL;
+
+EXIT:
+    return p_tree;
+}
+
+void
+bst_destroy (bst_t * p_tree)
+{
+    if (NULL == p_tree)
+    {
+        return;
+    }
+
+    if (p_tree->b_arena)
+    {
+        bst_arena_release(&p_tree->arena);
+    }
+    else
+    {
+        free_bst(p_tree->p_root);
+    }
+
+    free(p_tree);
+}
+
+int
+bst_insert (bst_t * p_tree, void * p_value)
+{
+    int status = -1;
+
+    if (NULL != p_tree)
+    {
+        status = bst_insert_into(&p_tree->p_root,
+                                 p_value,
+                                 p_tree->p_compare,
+                                 p_tree->b_arena ? &p_tree->arena : NULL);
+    }
+
+    return status;
+}
+
+node_t *
+bst_find (bst_t * p_tree, void * p_value)
+{
+    return (NULL == p_tree) ? NULL : find(p_tree->p_root, p_value);
+}
+
+int
+bst_delete (bst_t * p_tree, void * p_value)
+{
+    int status = -1;
+
+    if ((NULL != p_tree) && (NULL != p_value))
+    {
+        status = bst_delete_from(&p_tree->p_root,
+                                 p_value,
+                                 p_tree->b_arena ? &p_tree->arena : NULL);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Builds a perfectly balanced subtree from count ascending values:
+ * the middle value becomes the root, the smaller half its right subtree and
+ * the greater half its left. The recursion is log2(count) deep. Sets
+ * *p_b_failed and stops allocating if a node cannot be allocated; the nodes
+ * already built stay linked so the caller can release them.
+ */
+static node_t *
+bst_build_balanced (void **       pp_values,
+                    size_t        count,
+                    int (*p_compare)(void *, void *),
+                    bst_arena_t * p_arena,
+                    bool *        p_b_failed)
+{
+    node_t * p_node = NULL;
+    size_t   middle = count / 2;
+
+    if ((0 == count) || *p_b_failed)
+    {
+        goto EXIT;
+    }
+
+    p_node = bst_node_alloc(p_arena, pp_values[middle], p_compare);
+
+    if (NULL == p_node)
+    {
+        *p_b_failed = true;
+        goto EXIT;
+    }
+
+    p_node->p_right = bst_build_balanced(
+        pp_values, middle, p_compare, p_arena, p_b_failed);
+    p_node->p_left = bst_build_balanced(pp_values + middle + 1,
+                                        count - middle - 1,
+                                        p_compare,
+                                        p_arena,
+                                        p_b_failed);
+    update_node(p_node);
+
+EXIT:
+    return p_node;
+}
+
+int
+bst_build_sorted (bst_t * p_tree, void ** pp_values, size_t count)
+{
+    int  status     = -1;
+    bool b_failed   = false;
+    bool b_inverted = false;
+
+    if ((NULL == p_tree) || ((0 != count) && (NULL == pp_values)))
+    {
+        fprintf(stderr, "NULL pointer provided.\n");
+        goto EXIT;
+    }
+
+    if (NULL != p_tree->p_root)
+    {
+        fprintf(stderr, "Bulk build requires an empty tree.\n");
+        goto EXIT;
+    }
+
+    for (size_t index = 1; (index < count) && !b_inverted; index++)
+    {
+        b_inverted
+            = (0 <= p_tree->p_compare(pp_values[index - 1], pp_values[index]));
+    }
+
+    if (b_inverted)
+    {
+        fprintf(stderr,
+                "Bulk build values must be ascending and distinct.\n");
+        goto EXIT;
+    }
+
+    bst_arena_t * p_arena = p_tree->b_arena ? &p_tree->arena : NULL;
+    node_t *      p_root  = bst_build_balanced(
+        pp_values, count, p_tree->p_compare, p_arena, &b_failed);
+
+    if (b_failed)
+    {
+        bst_free_nodes(p_arena, p_root);
+        goto EXIT;
+    }
+
+    p_tree->p_root = p_root;
+    status         = 0;
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Orders two entries of a value pointer array with the tree's
+ * comparison function.
+ */
+static int
+bst_compare_entries (const void * p_left, const void * p_right, void * p_arg)
+{
+    bst_t * p_tree = (bst_t *)p_arg;
+
+    return p_tree->p_compare(*(void * const *)p_left,
+                             *(void * const *)p_right);
+}
+
+int
+bst_build (bst_t *               p_tree,
+           void **               pp_values,
+           size_t                count,
+           struct threadpool_t * p_pool)
+{
+    int     status    = -1;
+    void ** pp_sorted = NULL;
+
+    if ((NULL == p_tree) || ((0 != count) && (NULL == pp_values)))
+    {
+        fprintf(stderr, "NULL pointer provided.\n");
+        goto EXIT;
+    }
+
+    pp_sorted = malloc((0 == count ? 1 : count) * sizeof(void *));
+
+    if (NULL == pp_sorted)
+    {
+        fprintf(stderr, "Error: Memory not allocated!\n");
+        goto EXIT;
+    }
+
+    if (0 != count)
+    {
+        memcpy(pp_sorted, pp_values, count * sizeof(void *));
+    }
+
+    if (0
+        != parallel_sort(p_pool,
+                         pp_sorted,
+                         count,
+                         sizeof(void *),
+                         bst_compare_entries,
+                         p_tree))
+    {
+        goto EXIT;
+    }
+
+    status = bst_build_sorted(p_tree, pp_sorted, count);
+
+EXIT:
+    free(pp_sorted);
+
+    return status;
+}
+
+node_t *
+bst_select (node_t * p_root, size_t rank)
+{
+    // Smaller keys are stored to the right, so the right subtree holds the
+    // ranks below each node
+    while (NULL != p_root)
+    {
+        size_t smaller = node_size(p_root->p_right);
+
+        if (rank == smaller)
+        {
+            break;
+        }
+
+        if (rank < smaller)
+        {
+            p_root = p_root->p_right;
+        }
+        else
+        {
+            rank -= smaller + 1;
+            p_root = p_root->p_left;
+        }
+    }
+
+    return p_root;
+}
+
+size_t
+bst_rank (node_t * p_root, void * p_key)
+{
+    size_t rank = 0;
+
+    while (NULL != p_root)
+    {
+        int cmp_result = p_root->p_compare(p_root->p_value, p_key);
+
+        if (0 > cmp_result)
+        {
+            rank += node_size(p_root->p_right) + 1;
+            p_root = p_root->p_left;
+        }
+        else
+        {
+            if (0 == cmp_result)
+            {
+                rank += node_size(p_root->p_right);
+                break;
+            }
+
+            p_root = p_root->p_right;
+        }
+    }
+
+    return rank;
+}
+
+bst_frozen_t *
+bst_freeze (node_t * p_root)
+{
+    bst_frozen_t * p_frozen = NULL;
+    bst_cursor_t   cursor;
+    size_t         count = (NULL == p_root) ? 0 : p_root->size;
+    size_t         bytes = (count + 1) * sizeof(void *);
+
+    p_frozen = calloc(1, sizeof(bst_frozen_t));
+
+    if (NULL == p_frozen)
+    {
+        fprintf(stderr, "Error: Memory not allocated!\n");
+        goto EXIT;
+    }
+
+    // aligned_alloc wants a multiple of the alignment
+    bytes = (bytes + BST_FROZEN_ALIGNMENT - 1)
+            & ~((size_t)BST_FROZEN_ALIGNMENT - 1);
+    p_frozen->p_values = aligned_alloc(BST_FROZEN_ALIGNMENT, bytes);
+
+    if (NULL == p_frozen->p_values)
+    {
+        fprintf(stderr, "Error: Memory not allocated!\n");
+        free(p_frozen);
+        p_frozen = NULL;
+        goto EXIT;
+    }
+
+    p_frozen->p_values[0] = NULL;
+    p_frozen->count       = count;
+    p_frozen->p_compare   = (NULL == p_root) ? NULL : p_root->p_compare;
+
+    if (0 == count)
+    {
+        goto EXIT;
+    }
+
+    // Visit the slots in the in-order of the implicit tree while taking the
+    // values in ascending order, so each slot receives its value in turn
+    size_t slot = 1;
+
+    while ((slot << 1) <= count)
+    {
+        slot <<= 1;
+    }
+
+    bst_cursor_seek(&cursor, p_root, NULL, true);
+
+    for (size_t index = 0; index < count; index++)
+    {
+        p_frozen->p_values[slot] = bst_cursor_next(&cursor)->p_value;
+
+        if (((slot << 1) | 1) <= count)
+        {
+            slot = (slot << 1) | 1;
+
+            while ((slot << 1) <= count)
+            {
+                slot <<= 1;
+            }
+        }
+        else
+        {
+            // Climb past every level reached from the right
+            while (slot & 1)
+            {
+                slot >>= 1;
+            }
+
+            slot >>= 1;
+        }
+    }
+
+EXIT:
+    return p_frozen;
+}
+
+void
+bst_frozen_destroy (bst_frozen_t * p_frozen)
+{
+    if (NULL == p_frozen)
+    {
+        return;
+    }
+
+    free(p_frozen->p_values);
+    free(p_frozen);
+}
+
+/*
+ * Returns the slot of the least value not less than p_key, or 0. The descent
+ * turns the comparison into the low bit of the next slot instead of branching
+ * on it, so it always runs the full depth of the array.
+ */
+static size_t
+bst_frozen_search (bst_frozen_t * p_frozen, void * p_key)
+{
+    void ** p_values = p_frozen->p_values;
+    size_t  count    = p_frozen->count;
+    size_t  slot     = 1;
+
+    while (slot <= count)
+    {
+        // The 16 descendants four levels down share two cache lines
+        size_t ahead = slot << 4;
+
+        ahead = (ahead <= count) ? ahead : count;
+        __builtin_prefetch(&p_values[ahead]);
+        slot = (slot << 1)
+               | (size_t)(0 > p_frozen->p_compare(p_values[slot], p_key));
+    }
+
+    // Drop the right turns taken after the last left turn; the slot where
+    // the search last went left holds the answer
+    slot >>= __builtin_ffsll((long long)~slot);
+
+    return slot;
+}
+
+void *
+bst_frozen_find (bst_frozen_t * p_frozen, void * p_key)
+{
+    void * p_value = NULL;
+
+    if ((NULL == p_frozen) || (0 == p_frozen->count))
+    {
+        goto EXIT;
+    }
+
+    size_t slot = bst_frozen_search(p_frozen, p_key);
+
+    if ((0 != slot)
+        && (0 == p_frozen->p_compare(p_frozen->p_values[slot], p_key)))
+    {
+        p_value = p_frozen->p_values[slot];
+    }
+
+EXIT:
+    return p_value;
+}
+
+void *
+bst_frozen_lower_bound (bst_frozen_t * p_frozen, void * p_key)
+{
+    void * p_value = NULL;
+
+    if ((NULL == p_frozen) || (0 == p_frozen->count))
+    {
+        goto EXIT;
+    }
+
+    // Slot 0 holds NULL, standing for a key past every value
+    p_value = p_frozen->p_values[bst_frozen_search(p_frozen, p_key)];
+
+EXIT:
+    return p_value;
 }
 
 int
@@ -353,13 +1357,13 @@ int
 main (void)
 {
     node_t * root = create_node(&(int){ 50 }, compare_int);
-    insert(root, &(int){ 45 }, compare_int);
-    insert(root, &(int){ 60 }, compare_int);
-    insert(root, &(int){ 30 }, compare_int);
-    insert(root, &(int){ 47 }, compare_int);
-    insert(root, &(int){ 58 }, compare_int);
-    insert(root, &(int){ 70 }, compare_int);
-    insert(root, &(int){ 68 }, compare_int);
+    root          = insert(root, &(int){ 45 }, compare_int);
+    root          = insert(root, &(int){ 60 }, compare_int);
+    root          = insert(root, &(int){ 30 }, compare_int);
+    root          = insert(root, &(int){ 47 }, compare_int);
+    root          = insert(root, &(int){ 58 }, compare_int);
+    root          = insert(root, &(int){ 70 }, compare_int);
+    root          = insert(root, &(int){ 68 }, compare_int);
 
     int val = 32;
 
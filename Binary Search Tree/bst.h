@@ -3,14 +3,102 @@
 #include <string.h>
 #include <stdbool.h>
 
+/*
+ * An AVL tree of n nodes is less than 1.4405 log2(n + 2) levels tall, so
+ * every path through a tree with fewer than 2^64 nodes fits in 96 entries.
+ * The iterative operations keep their paths in stack arrays of this size.
+ */
+#define BST_MAX_HEIGHT 96
+
+struct threadpool_t;
+
 typedef struct node_t
 {
     void * p_value;
     int (*p_compare)(void *, void *);
     struct node_t * p_right;
     struct node_t * p_left;
+    int             height;
+    size_t          size;
 } node_t;
 
+/*
+ * In-order iterator over a tree, in the order print_inorder() prints: greater
+ * keys are stored to the left, so nodes come out in descending order of
+ * p_compare. The tree must not change while it is iterated.
+ */
+typedef struct bst_iterator_t
+{
+    node_t * p_stack[BST_MAX_HEIGHT];
+    size_t   depth;
+} bst_iterator_t;
+
+/*
+ * Resumable cursor visiting nodes in ascending order of p_compare, starting
+ * from a given key. The stack holds the nodes still to be returned along the
+ * current path, so each step costs O(1) amortized.
+ */
+typedef struct bst_cursor_t
+{
+    node_t * p_stack[BST_MAX_HEIGHT];
+    size_t   depth;
+} bst_cursor_t;
+
+/*
+ * Nodes of an arena-backed tree come from blocks of BST_ARENA_FIRST_BLOCK
+ * nodes, doubling up to BST_ARENA_MAX_BLOCK, so a million-node tree takes a
+ * few dozen allocations. Deleted nodes go on a free list for reuse, and
+ * destroying the tree frees the blocks without visiting a node.
+ */
+#define BST_ARENA_FIRST_BLOCK 64
+#define BST_ARENA_MAX_BLOCK   65536
+
+typedef struct bst_arena_block_t
+{
+    struct bst_arena_block_t * p_next;
+    size_t                     capacity;
+    size_t                     used;
+    node_t                     nodes[];
+} bst_arena_block_t;
+
+typedef struct bst_arena_t
+{
+    bst_arena_block_t * p_blocks;
+    node_t *            p_free;
+} bst_arena_t;
+
+/*
+ * A tree handle: the root, the comparison function, and the arena its nodes
+ * come from when b_arena is set. The node_t functions below still work on
+ * p_root for lookups and traversal; inserting and deleting must go through
+ * the handle so that nodes are allocated and released consistently.
+ */
+typedef struct bst_t
+{
+    node_t * p_root;
+    int (*p_compare)(void *, void *);
+    bool        b_arena;
+    bst_arena_t arena;
+} bst_t;
+
+/*
+ * A frozen tree: the values of a tree copied, in ascending order of
+ * p_compare, into one cache-aligned array laid out in Eytzinger order. Slot 1
+ * holds the root and slot k has its children at 2k and 2k + 1, so a search
+ * follows no pointers, descends without a branch on the comparison, and
+ * finds the slots of the next four levels on the same two cache lines,
+ * which it prefetches. Slot 0 is unused. The array takes one pointer per
+ * value where the tree takes a whole node_t.
+ */
+#define BST_FROZEN_ALIGNMENT 64
+
+typedef struct bst_frozen_t
+{
+    void ** p_values;
+    size_t  count;
+    int (*p_compare)(void *, void *);
+} bst_frozen_t;
+
 typedef struct trunk_t
 {
     struct trunk_t * prev;
@@ -34,3 +122,86 @@ void     print_postorder (node_t * p_node);
 void     print_inorder (node_t * p_node);
 void     print_preorder (node_t * p_node);
 void     free_bst (node_t * p_node);
+void     bst_iterator_init (bst_iterator_t * p_iterator, node_t * p_root);
+node_t * bst_iterator_next (bst_iterator_t * p_iterator);
+
+/*
+ * Ordered lookups, all in ascending order of p_compare. lower_bound returns
+ * the first node whose key is not less than p_key, upper_bound the first
+ * whose key is greater; successor and predecessor return the neighbours of a
+ * node's key. Each returns NULL when there is no such node.
+ */
+node_t * bst_lower_bound (node_t * p_root, void * p_key);
+node_t * bst_upper_bound (node_t * p_root, void * p_key);
+node_t * bst_successor (node_t * p_root, node_t * p_node);
+node_t * bst_predecessor (node_t * p_root, node_t * p_node);
+
+/*
+ * Positions a cursor at the first key not less than p_from (b_inclusive) or
+ * greater than p_from, or at the smallest key if p_from is NULL. The tree
+ * must not change between calls to bst_cursor_next(); after it does, resume
+ * by seeking past the last key returned with b_inclusive false.
+ */
+void     bst_cursor_seek (bst_cursor_t * p_cursor,
+                          node_t *       p_root,
+                          void *         p_from,
+                          bool           b_inclusive);
+node_t * bst_cursor_next (bst_cursor_t * p_cursor);
+
+/*
+ * Calls p_visit on the value of every node from p_low to p_high inclusive,
+ * in ascending order, until it returns false. A NULL bound leaves that end
+ * open. Only the O(log n + k) nodes on the way to the k keys in range are
+ * touched. Returns the number of calls made.
+ */
+size_t bst_range (node_t * p_root,
+                  void *   p_low,
+                  void *   p_high,
+                  bool (*p_visit)(void * p_value, void * p_context),
+                  void * p_context);
+
+/*
+ * Handle API: bst_insert and bst_delete return 0 on success and -1 if the
+ * value was already present, missing, or could not be allocated.
+ */
+bst_t *  bst_create (int (*p_compare)(void *, void *), bool b_arena);
+void     bst_destroy (bst_t * p_tree);
+int      bst_insert (bst_t * p_tree, void * p_value);
+node_t * bst_find (bst_t * p_tree, void * p_value);
+int      bst_delete (bst_t * p_tree, void * p_value);
+
+/*
+ * Bulk loading into an empty tree. bst_build_sorted takes values already in
+ * ascending order of the tree's comparison function and links them into a
+ * perfectly balanced tree in O(n), with no comparisons beyond the n - 1 that
+ * check the order. bst_build sorts a copy of unsorted values with
+ * parallel_sort() on p_pool, which may be NULL, and then builds the same way.
+ * Both return -1, leaving the tree empty, if the values are not distinct or
+ * memory runs out.
+ */
+int bst_build_sorted (bst_t * p_tree, void ** pp_values, size_t count);
+int bst_build (bst_t *               p_tree,
+               void **               pp_values,
+               size_t                count,
+               struct threadpool_t * p_pool);
+
+/*
+ * Order statistics, from the subtree size every node keeps. bst_select
+ * returns the node of 0-based rank in ascending order of p_compare, or NULL
+ * if rank is not below the number of nodes; bst_rank returns how many keys
+ * are less than p_key. Both walk a single path, in O(log n).
+ */
+node_t * bst_select (node_t * p_root, size_t rank);
+size_t   bst_rank (node_t * p_root, void * p_key);
+
+/*
+ * Read-only snapshots. bst_freeze copies the values of the tree at p_root
+ * into a new bst_frozen_t, in O(n), and leaves the tree untouched; the values
+ * themselves are shared, not copied. bst_frozen_find returns the stored value
+ * equal to p_key and bst_frozen_lower_bound the least one not less than it,
+ * or NULL. bst_freeze returns NULL if memory runs out.
+ */
+bst_frozen_t * bst_freeze (node_t * p_root);
+void           bst_frozen_destroy (bst_frozen_t * p_frozen);
+void *         bst_frozen_find (bst_frozen_t * p_frozen, void * p_key);
+void *         bst_frozen_lower_bound (bst_frozen_t * p_frozen, void * p_key);
@@ -1,4 +1,164 @@
+#define _GNU_SOURCE
 #include "dynamic_array.h"
+#include "parallel_sort.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Defines how many elements the equality scan compares before it
+ * checks for a match, so the inner loop has no early exit and vectorizes
+ *
+ */
+#define DYNAMIC_ARRAY_SCAN_BLOCK 64
+
+/**
+ * @brief Defines the offset of the first element in the file of a
+ * file-backed array
+ *
+ */
+#define DYNAMIC_ARRAY_HEADER_SIZE sizeof(dynamic_array_file_header_t)
+
+typedef uint16_t __attribute__((may_alias)) dynamic_array_u16_t;
+typedef uint32_t __attribute__((may_alias)) dynamic_array_u32_t;
+typedef uint64_t __attribute__((may_alias)) dynamic_array_u64_t;
+
+/**
+ * @brief Defines a scan returning the index of the first element equal to
+ * key, or size if there is none.
+ *
+ */
+#define DYNAMIC_ARRAY_DEFINE_SCAN(name, type)                                 \
+    static size_t name (const type * p_data, size_t size, type key)          \
+    {                                                                         \
+        size_t index = 0;                                                     \
+                                                                              \
+        for (; (index + DYNAMIC_ARRAY_SCAN_BLOCK) <= size;                    \
+             index += DYNAMIC_ARRAY_SCAN_BLOCK)                               \
+        {                                                                     \
+            unsigned int hits = 0;                                            \
+                                                                              \
+            for (size_t lane = 0; lane < DYNAMIC_ARRAY_SCAN_BLOCK; lane++)    \
+            {                                                                 \
+                hits |= (p_data[index + lane] == key);                        \
+            }                                                                 \
+                                                                              \
+            if (0 != hits)                                                    \
+            {                                                                 \
+                break;                                                        \
+            }                                                                 \
+        }                                                                     \
+                                                                              \
+        while ((index < size) && (p_data[index] != key))                      \
+        {                                                                     \
+            index++;                                                          \
+        }                                                                     \
+                                                                              \
+        return index;                                                         \
+    }
+
+DYNAMIC_ARRAY_DEFINE_SCAN(dynamic_array_scan_8, uint8_t)
+DYNAMIC_ARRAY_DEFINE_SCAN(dynamic_array_scan_16, dynamic_array_u16_t)
+DYNAMIC_ARRAY_DEFINE_SCAN(dynamic_array_scan_32, dynamic_array_u32_t)
+DYNAMIC_ARRAY_DEFINE_SCAN(dynamic_array_scan_64, dynamic_array_u64_t)
+
+/**
+ * @brief Returns the address of the slot holding element index.
+ */
+static inline void *
+dynamic_array_slot (const dynamic_array_t * p_array, size_t index)
+{
+    return p_array->p_data + (index * p_array->elem_size);
+}
+
+/**
+ * @brief Returns what callbacks and getters receive for an element: the
+ * stored pointer for pointer arrays, or the element's address for inline
+ * arrays.
+ */
+static inline void *
+dynamic_array_element (const dynamic_array_t * p_array, size_t index)
+{
+    void * p_element = dynamic_array_slot(p_array, index);
+
+    if (!p_array->b_inline)
+    {
+        p_element = *(void **)p_element;
+    }
+
+    return p_element;
+}
+
+static void
+dynamic_array_destroy_element (dynamic_array_t * p_array, size_t index)
+{
+    void * p_element = dynamic_array_element(p_array, index);
+
+    if ((NULL != p_array->p_destroy_function) && (NULL != p_element))
+    {
+        p_array->p_destroy_function(p_element);
+    }
+}
+
+static dynamic_array_t *
+dynamic_array_create (size_t capacity,
+                      size_t elem_size,
+                      bool   b_inline,
+                      bool (*bp_compare)(void *, void *),
+                      void (*p_destroy)(void *))
+{
+    dynamic_array_t * p_array = calloc(1, sizeof(dynamic_array_t));
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_init(&p_array->array_lock, NULL))
+    {
+        fprintf(stderr, "Dynamic array lock initialization failed.\n");
+        free(p_array);
+        p_array = NULL;
+        goto EXIT;
+    }
+
+    if (0 == capacity)
+    {
+        capacity = INITIAL_ARRAY_CAPACITY;
+    }
+
+    p_array->p_data = calloc(capacity, elem_size);
+
+    if (NULL == p_array->p_data)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        pthread_rwlock_destroy(&p_array->array_lock);
+        free(p_array);
+        p_array = NULL;
+        goto EXIT;
+    }
+
+    p_array->elem_size          = elem_size;
+    p_array->b_inline           = b_inline;
+    p_array->size               = 0;
+    p_array->capacity           = capacity;
+    p_array->growth_numerator   = ARRAY_GROWTH_NUMERATOR;
+    p_array->growth_denominator = ARRAY_GROWTH_DENOMINATOR;
+    p_array->bp_compare         = bp_compare;
+    p_array->p_destroy_function = p_destroy;
+    p_array->p_order            = NULL;
+    p_array->b_sorted           = false;
+    p_array->fd                 = -1;
+    p_array->p_map              = NULL;
+    p_array->map_size           = 0;
+
+EXIT:
+    return p_array;
+}
 
 dynamic_array_t *
 dynamic_array_init (size_t capacity,
@@ -7,125 +167,1390 @@ dynamic_array_init (size_t capacity,
 {
     dynamic_array_t * p_array = NULL;
 
-    if ((NULL == bp_compare) || (NULL == p_destroy))
+    if ((NULL == bp_compare) || (NULL == p_destroy))
+    {
+        fprintf(stderr, "Provided NULL function pointers to array.\n");
+        goto EXIT;
+    }
+
+    p_array = dynamic_array_create(
+        capacity, sizeof(void *), false, bp_compare, p_destroy);
+
+EXIT:
+    return p_array;
+}
+
+dynamic_array_t *
+dynamic_array_init_sized (size_t capacity,
+                          size_t elem_size,
+                          bool (*bp_compare)(void *, void *),
+                          void (*p_destroy)(void *))
+{
+    dynamic_array_t * p_array = NULL;
+
+    if (0 == elem_size)
+    {
+        fprintf(stderr, "Dynamic array element size must not be 0.\n");
+        goto EXIT;
+    }
+
+    p_array = dynamic_array_create(
+        capacity, elem_size, true, bp_compare, p_destroy);
+
+EXIT:
+    return p_array;
+}
+
+/**
+ * @brief Opens and maps the backing file, creating it with room for capacity
+ * elements if it is empty, and points p_data past the header. On failure the
+ * file is closed and the array is left unmapped.
+ */
+static int
+dynamic_array_open_file (dynamic_array_t * p_array,
+                         const char *      p_path,
+                         size_t            capacity)
+{
+    int                           status   = SUCCESS;
+    size_t                        header_size = DYNAMIC_ARRAY_HEADER_SIZE;
+    struct stat                   file_stat;
+    dynamic_array_file_header_t * p_header = NULL;
+    bool                          b_new    = false;
+
+    p_array->fd = open(p_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (0 > p_array->fd)
+    {
+        fprintf(stderr, "Failed to open %s.\n", p_path);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != fstat(p_array->fd, &file_stat))
+    {
+        fprintf(stderr, "Failed to stat %s.\n", p_path);
+        status = FAILURE;
+        goto EXIT_CLOSE;
+    }
+
+    if (0 == file_stat.st_size)
+    {
+        if (((SIZE_MAX - header_size) / p_array->elem_size) < capacity)
+        {
+            status = FAILURE;
+            goto EXIT_CLOSE;
+        }
+
+        b_new             = true;
+        p_array->map_size = header_size + (capacity * p_array->elem_size);
+
+        if (0 != ftruncate(p_array->fd, (off_t)p_array->map_size))
+        {
+            fprintf(stderr, "Failed to size %s.\n", p_path);
+            status = FAILURE;
+            goto EXIT_CLOSE;
+        }
+    }
+    else if ((size_t)file_stat.st_size < header_size)
+    {
+        fprintf(stderr, "%s is not a dynamic array file.\n", p_path);
+        status = FAILURE;
+        goto EXIT_CLOSE;
+    }
+    else
+    {
+        p_array->map_size = (size_t)file_stat.st_size;
+    }
+
+    p_array->p_map = mmap(NULL,
+                          p_array->map_size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          p_array->fd,
+                          0);
+
+    if (MAP_FAILED == p_array->p_map)
+    {
+        fprintf(stderr, "Failed to map %s.\n", p_path);
+        p_array->p_map = NULL;
+        status         = FAILURE;
+        goto EXIT_CLOSE;
+    }
+
+    p_header          = (dynamic_array_file_header_t *)p_array->p_map;
+    p_array->capacity
+        = (p_array->map_size - header_size) / p_array->elem_size;
+
+    if (b_new)
+    {
+        p_header->magic     = DYNAMIC_ARRAY_FILE_MAGIC;
+        p_header->elem_size = p_array->elem_size;
+        p_header->size      = 0;
+    }
+    else if ((DYNAMIC_ARRAY_FILE_MAGIC != p_header->magic)
+             || (p_array->elem_size != p_header->elem_size)
+             || (p_array->capacity < p_header->size))
+    {
+        fprintf(stderr, "%s is not a dynamic array file.\n", p_path);
+        munmap(p_array->p_map, p_array->map_size);
+        p_array->p_map = NULL;
+        status         = FAILURE;
+        goto EXIT_CLOSE;
+    }
+
+    p_array->size   = (size_t)p_header->size;
+    p_array->p_data = p_array->p_map + header_size;
+    goto EXIT;
+
+EXIT_CLOSE:
+    close(p_array->fd);
+    p_array->fd = -1;
+
+EXIT:
+    return status;
+}
+
+dynamic_array_t *
+dynamic_array_init_mapped (const char * p_path,
+                           size_t       capacity,
+                           size_t       elem_size,
+                           bool (*bp_compare)(void *, void *),
+                           void (*p_destroy)(void *))
+{
+    dynamic_array_t * p_array = NULL;
+
+    if (NULL == p_path)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (0 == elem_size)
+    {
+        fprintf(stderr, "Dynamic array element size must not be 0.\n");
+        goto EXIT;
+    }
+
+    if (0 == capacity)
+    {
+        capacity = INITIAL_ARRAY_CAPACITY;
+    }
+
+    // Built as a one-element heap array, whose buffer the mapping replaces
+    p_array = dynamic_array_create(1, elem_size, true, bp_compare, p_destroy);
+
+    if (NULL == p_array)
+    {
+        goto EXIT;
+    }
+
+    free(p_array->p_data);
+    p_array->p_data = NULL;
+
+    if (SUCCESS != dynamic_array_open_file(p_array, p_path, capacity))
+    {
+        pthread_rwlock_destroy(&p_array->array_lock);
+        free(p_array);
+        p_array = NULL;
+    }
+
+EXIT:
+    return p_array;
+}
+
+/**
+ * @brief For optimistic arrays, makes the sequence odd so that readers in
+ * progress retry. The caller holds the write lock.
+ */
+static void
+dynamic_array_write_begin (dynamic_array_t * p_array)
+{
+    if (p_array->b_optimistic)
+    {
+        __atomic_store_n(
+            &p_array->sequence, p_array->sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Makes the sequence of optimistic arrays even again, publishing the
+ * writer's changes. The caller holds the write lock.
+ */
+static void
+dynamic_array_write_end (dynamic_array_t * p_array)
+{
+    if (p_array->b_optimistic)
+    {
+        __atomic_store_n(
+            &p_array->sequence, p_array->sequence + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Takes the write lock and, for optimistic arrays, makes the sequence
+ * odd so that readers in progress retry.
+ */
+static int
+dynamic_array_write_lock (dynamic_array_t * p_array)
+{
+    int status = pthread_rwlock_wrlock(&p_array->array_lock);
+
+    if (0 == status)
+    {
+        dynamic_array_write_begin(p_array);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Makes the sequence of optimistic arrays even again, publishing the
+ * writer's changes, and releases the write lock.
+ */
+static void
+dynamic_array_write_unlock (dynamic_array_t * p_array)
+{
+    dynamic_array_write_end(p_array);
+    pthread_rwlock_unlock(&p_array->array_lock);
+}
+
+static void
+dynamic_array_free_retired (dynamic_array_t * p_array)
+{
+    for (size_t index = 0; index < p_array->num_retired; index++)
+    {
+        free(p_array->pp_retired[index]);
+    }
+
+    p_array->num_retired = 0;
+}
+
+void
+dynamic_array_destroy (dynamic_array_t * p_array)
+{
+    fprintf(stdout, "Cleaning up array...\n");
+
+    if (NULL == p_array)
+    {
+        goto EXIT;
+    }
+
+    pthread_rwlock_wrlock(&p_array->array_lock);
+
+    if (0 <= p_array->fd)
+    {
+        // The elements persist, so only the mapping and the file are released
+        ((dynamic_array_file_header_t *)p_array->p_map)->size = p_array->size;
+        msync(p_array->p_map, p_array->map_size, MS_SYNC);
+        munmap(p_array->p_map, p_array->map_size);
+        close(p_array->fd);
+        p_array->p_map  = NULL;
+        p_array->p_data = NULL;
+        p_array->fd     = -1;
+    }
+
+    if (NULL != p_array->p_data)
+    {
+
+        for (size_t index = 0; index < p_array->size; index++)
+        {
+            dynamic_array_destroy_element(p_array, index);
+        }
+
+        free(p_array->p_data);
+        p_array->p_data = NULL;
+    }
+
+    dynamic_array_free_retired(p_array);
+    free(p_array->pp_retired);
+    p_array->pp_retired = NULL;
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+    pthread_rwlock_destroy(&p_array->array_lock);
+
+    free(p_array);
+    p_array = NULL;
+
+EXIT:
+    return;
+}
+
+/**
+ * @brief Makes room in pp_retired for one more buffer, so that a buffer can
+ * be replaced without a failure after the new one is ready. The caller holds
+ * the write lock.
+ */
+static int
+dynamic_array_reserve_retired (dynamic_array_t * p_array)
+{
+    int status = SUCCESS;
+
+    if (p_array->num_retired == p_array->retired_capacity)
+    {
+        size_t retired_capacity = DOUBLE * p_array->retired_capacity;
+
+        if (0 == retired_capacity)
+        {
+            retired_capacity = INITIAL_ARRAY_CAPACITY;
+        }
+
+        uint8_t ** pp_temp = realloc(p_array->pp_retired,
+                                     retired_capacity * sizeof(uint8_t *));
+
+        if (NULL == pp_temp)
+        {
+            fprintf(stderr, "Memory reallocation error\n");
+            status = FAILURE;
+            goto EXIT;
+        }
+
+        p_array->pp_retired       = pp_temp;
+        p_array->retired_capacity = retired_capacity;
+    }
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Retires the buffer of an optimistic array and publishes p_new, of
+ * new_capacity elements, in its place. The old buffer may still be read by
+ * optimistic readers, so it is kept until dynamic_array_reclaim(). The caller
+ * holds the write lock and has called dynamic_array_reserve_retired().
+ */
+static void
+dynamic_array_replace_unlocked (dynamic_array_t * p_array,
+                                uint8_t *         p_new,
+                                size_t            new_capacity)
+{
+    p_array->pp_retired[p_array->num_retired] = p_array->p_data;
+    p_array->num_retired++;
+
+    __atomic_store_n(&p_array->p_data, p_new, __ATOMIC_RELEASE);
+    p_array->capacity = new_capacity;
+}
+
+/**
+ * @brief Grows an optimistic array by copying into a new buffer, which
+ * replaces the old one. Buffers never shrink in this mode, so a reader that
+ * loads the size before the buffer always finds the index inside the buffer
+ * it loaded. The caller holds the write lock.
+ */
+static int
+dynamic_array_republish_unlocked (dynamic_array_t * p_array,
+                                  size_t            new_capacity)
+{
+    int       status = SUCCESS;
+    uint8_t * p_new  = NULL;
+
+    if ((new_capacity < p_array->capacity)
+        || (SUCCESS != dynamic_array_reserve_retired(p_array)))
+    {
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_new = malloc(new_capacity * p_array->elem_size);
+
+    if (NULL == p_new)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    memcpy(p_new, p_array->p_data, p_array->size * p_array->elem_size);
+    dynamic_array_replace_unlocked(p_array, p_new, new_capacity);
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Resizes the backing file and its mapping, which may move. The file
+ * grows before the mapping and shrinks after it, so no mapped page ever lies
+ * past the end of the file. The caller holds the write lock.
+ */
+static int
+dynamic_array_remap_unlocked (dynamic_array_t * p_array, size_t new_capacity)
+{
+    int       status      = SUCCESS;
+    size_t    header_size = DYNAMIC_ARRAY_HEADER_SIZE;
+    size_t    new_size    = header_size + (new_capacity * p_array->elem_size);
+    uint8_t * p_new       = NULL;
+
+    if (new_size < header_size)
+    {
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if ((new_size > p_array->map_size)
+        && (0 != ftruncate(p_array->fd, (off_t)new_size)))
+    {
+        fprintf(stderr, "Failed to grow the array file.\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_new = mremap(p_array->p_map, p_array->map_size, new_size, MREMAP_MAYMOVE);
+
+    if (MAP_FAILED == p_new)
+    {
+        fprintf(stderr, "Failed to remap the array file.\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (new_size < p_array->map_size)
+    {
+        // A failed truncation only leaves unused space at the end of the file
+        (void)ftruncate(p_array->fd, (off_t)new_size);
+    }
+
+    p_array->p_map    = p_new;
+    p_array->map_size = new_size;
+    p_array->p_data   = p_new + header_size;
+    p_array->capacity = new_capacity;
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Reallocates the element storage. The caller holds the write lock.
+ */
+static int
+dynamic_array_resize_unlocked (dynamic_array_t * p_array, size_t new_capacity)
+{
+    int status = SUCCESS;
+
+    if ((0 == new_capacity) || (new_capacity < p_array->size)
+        || ((SIZE_MAX / p_array->elem_size) < new_capacity))
+    {
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->b_optimistic)
+    {
+        status = dynamic_array_republish_unlocked(p_array, new_capacity);
+        goto EXIT;
+    }
+
+    if (0 <= p_array->fd)
+    {
+        status = dynamic_array_remap_unlocked(p_array, new_capacity);
+        goto EXIT;
+    }
+
+    uint8_t * p_temp
+        = realloc(p_array->p_data, new_capacity * p_array->elem_size);
+
+    if (NULL == p_temp)
+    {
+        fprintf(stderr, "Memory reallocation error\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_array->p_data   = p_temp;
+    p_array->capacity = new_capacity;
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Makes room for count more elements. Capacity grows by the growth
+ * factor, or straight to the required size when that is larger, so a bulk
+ * insert reallocates at most once. The caller holds the write lock.
+ */
+static int
+dynamic_array_ensure_unlocked (dynamic_array_t * p_array, size_t count)
+{
+    int    status       = SUCCESS;
+    size_t capacity     = p_array->capacity;
+    size_t needed       = p_array->size + count;
+    size_t new_capacity = SIZE_MAX;
+
+    if (needed < p_array->size)
+    {
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (needed <= capacity)
+    {
+        goto EXIT;
+    }
+
+    if ((SIZE_MAX / p_array->growth_numerator) >= capacity)
+    {
+        new_capacity = (capacity * p_array->growth_numerator)
+                       / p_array->growth_denominator;
+    }
+
+    if (new_capacity < needed)
+    {
+        new_capacity = needed;
+    }
+
+    status = dynamic_array_resize_unlocked(p_array, new_capacity);
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Halves the capacity while the size is below capacity /
+ * ARRAY_SHRINK_THRESHOLD, never going under INITIAL_ARRAY_CAPACITY. A failed
+ * shrink leaves the larger buffer in place, which is harmless. The caller
+ * holds the write lock.
+ */
+static void
+dynamic_array_shrink_unlocked (dynamic_array_t * p_array)
+{
+    size_t new_capacity = p_array->capacity;
+
+    while (!p_array->b_optimistic
+           && (p_array->size < (new_capacity / ARRAY_SHRINK_THRESHOLD))
+           && (INITIAL_ARRAY_CAPACITY <= (new_capacity / ARRAY_SIZE_DIVISOR)))
+    {
+        new_capacity /= ARRAY_SIZE_DIVISOR;
+    }
+
+    if (new_capacity != p_array->capacity)
+    {
+        (void)dynamic_array_resize_unlocked(p_array, new_capacity);
+    }
+}
+
+/**
+ * @brief Copies count elements from p_source into the array at index,
+ * shifting the tail up once. The caller holds the write lock and has checked
+ * that index is at most the size.
+ */
+static int
+dynamic_array_insert_unlocked (dynamic_array_t * p_array,
+                               size_t            index,
+                               const void *      p_source,
+                               size_t            count)
+{
+    int status = dynamic_array_ensure_unlocked(p_array, count);
+
+    if (SUCCESS != status)
+    {
+        goto EXIT;
+    }
+
+    memmove(dynamic_array_slot(p_array, index + count),
+            dynamic_array_slot(p_array, index),
+            (p_array->size - index) * p_array->elem_size);
+    memcpy(dynamic_array_slot(p_array, index),
+           p_source,
+           count * p_array->elem_size);
+    __atomic_store_n(&p_array->size, p_array->size + count, __ATOMIC_RELEASE);
+    p_array->b_sorted = false;
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Destroys count elements starting at index and closes the gap with a
+ * single move. The caller holds the write lock and has checked the range.
+ */
+static void
+dynamic_array_erase_unlocked (dynamic_array_t * p_array,
+                              size_t            index,
+                              size_t            count)
+{
+    for (size_t offset = 0; offset < count; offset++)
+    {
+        dynamic_array_destroy_element(p_array, index + offset);
+    }
+
+    memmove(dynamic_array_slot(p_array, index),
+            dynamic_array_slot(p_array, index + count),
+            (p_array->size - index - count) * p_array->elem_size);
+
+    __atomic_store_n(&p_array->size, p_array->size - count, __ATOMIC_RELEASE);
+    dynamic_array_shrink_unlocked(p_array);
+}
+
+int
+dynamic_array_resize (dynamic_array_t * p_array, size_t new_capacity)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    status = dynamic_array_resize_unlocked(p_array, new_capacity);
+
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_set_growth (dynamic_array_t * p_array,
+                          size_t            numerator,
+                          size_t            denominator)
+{
+    int status = SUCCESS;
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if ((0 == denominator) || (numerator <= denominator))
+    {
+        fprintf(stderr, "Growth factor must be greater than 1.\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_array->growth_numerator   = numerator;
+    p_array->growth_denominator = denominator;
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_reserve (dynamic_array_t * p_array, size_t min_capacity)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->capacity < min_capacity)
+    {
+        status = dynamic_array_resize_unlocked(p_array, min_capacity);
+    }
+
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_shrink_to_fit (dynamic_array_t * p_array)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    size_t new_capacity = (0 == p_array->size) ? 1 : p_array->size;
+
+    // Optimistic arrays never shrink; see dynamic_array_republish_unlocked()
+    if (!p_array->b_optimistic && (new_capacity != p_array->capacity))
+    {
+        status = dynamic_array_resize_unlocked(p_array, new_capacity);
+    }
+
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Appends a copy of the elem_size bytes at p_source.
+ */
+static int
+dynamic_array_append (dynamic_array_t * p_array, const void * p_source)
+{
+    int status = SUCCESS;
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    status = dynamic_array_insert_unlocked(p_array, p_array->size, p_source, 1);
+
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_insert (dynamic_array_t * p_array, void * p_element)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data)
+        || (p_array->b_inline && (NULL == p_element)))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    status = dynamic_array_append(p_array,
+                                  p_array->b_inline ? p_element : &p_element);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_push (dynamic_array_t * p_array, const void * p_element)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_element))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    status = dynamic_array_append(p_array, p_element);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_remove (dynamic_array_t * p_array, size_t index)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->size <= index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    dynamic_array_erase_unlocked(p_array, index, 1);
+
+EXIT_UNLOCK:
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_append_range (dynamic_array_t * p_array,
+                            const void *      p_elements,
+                            size_t            count)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data)
+        || ((NULL == p_elements) && (0 != count)))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    // Nothing to copy, and the order of the array is unchanged
+    if (0 == count)
+    {
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    status = dynamic_array_insert_unlocked(
+        p_array, p_array->size, p_elements, count);
+
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_insert_at (dynamic_array_t * p_array,
+                         size_t            index,
+                         void *            p_element)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data)
+        || (p_array->b_inline && (NULL == p_element)))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->size < index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    status = dynamic_array_insert_unlocked(
+        p_array, index, p_array->b_inline ? p_element : &p_element, 1);
+
+EXIT_UNLOCK:
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_erase_range (dynamic_array_t * p_array,
+                           size_t            index,
+                           size_t            count)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if ((p_array->size < index) || ((p_array->size - index) < count))
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    dynamic_array_erase_unlocked(p_array, index, count);
+
+EXIT_UNLOCK:
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_swap_remove (dynamic_array_t * p_array, size_t index)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != dynamic_array_write_lock(p_array))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->size <= index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    size_t last = p_array->size - 1;
+
+    dynamic_array_destroy_element(p_array, index);
+
+    if (index != last)
+    {
+        memcpy(dynamic_array_slot(p_array, index),
+               dynamic_array_slot(p_array, last),
+               p_array->elem_size);
+        p_array->b_sorted = false;
+    }
+
+    __atomic_store_n(&p_array->size, last, __ATOMIC_RELEASE);
+    dynamic_array_shrink_unlocked(p_array);
+
+EXIT_UNLOCK:
+    dynamic_array_write_unlock(p_array);
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Seqlock read of an optimistic array: copies the element at index to
+ * p_out, when not NULL, and returns its slot, retrying while a writer is
+ * active or has intervened. Returns NULL when index is out of bounds.
+ */
+static void *
+dynamic_array_read_optimistic (dynamic_array_t * p_array,
+                               size_t            index,
+                               void *            p_out)
+{
+    void *        p_slot   = NULL;
+    unsigned long sequence = 0;
+
+    // Join the readers of the current epoch before loading the buffer. The
+    // fence pairs with the one in dynamic_array_wait_readers(): either reclaim
+    // sees this read counted, or this read loads a buffer it does not free.
+    unsigned long * p_readers
+        = &p_array->readers[__atomic_load_n(&p_array->reclaim_epoch,
+                                            __ATOMIC_ACQUIRE)
+                            & 1];
+
+    __atomic_fetch_add(p_readers, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    do
+    {
+        sequence = __atomic_load_n(&p_array->sequence, __ATOMIC_ACQUIRE);
+
+        // The size is loaded before the buffer it indexes; see
+        // dynamic_array_republish_unlocked()
+        size_t    size   = __atomic_load_n(&p_array->size, __ATOMIC_ACQUIRE);
+        uint8_t * p_data = __atomic_load_n(&p_array->p_data, __ATOMIC_ACQUIRE);
+
+        p_slot = NULL;
+
+        if (index < size)
+        {
+            p_slot = p_data + (index * p_array->elem_size);
+
+            if (NULL != p_out)
+            {
+                memcpy(p_out, p_slot, p_array->elem_size);
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((0 != (sequence & 1))
+             || (sequence
+                 != __atomic_load_n(&p_array->sequence, __ATOMIC_RELAXED)));
+
+    __atomic_fetch_sub(p_readers, 1, __ATOMIC_RELEASE);
+
+    return p_slot;
+}
+
+void *
+dynamic_array_get_element (dynamic_array_t * p_array, size_t index)
+{
+    void * p_item = NULL;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (__atomic_load_n(&p_array->b_optimistic, __ATOMIC_ACQUIRE))
+    {
+        void * p_slot = dynamic_array_read_optimistic(
+            p_array, index, p_array->b_inline ? NULL : &p_item);
+
+        if (NULL == p_slot)
+        {
+            fprintf(stderr, "Array index out of bounds.\n");
+        }
+        else if (p_array->b_inline)
+        {
+            p_item = p_slot;
+        }
+
+        goto EXIT;
+    }
+
+    if (0 == pthread_rwlock_rdlock(&p_array->array_lock))
+    {
+
+        if (p_array->size <= index)
+        {
+            fprintf(stderr, "Array index out of bounds.\n");
+        }
+        else
+        {
+            p_item = dynamic_array_element(p_array, index);
+        }
+    }
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return p_item;
+}
+
+int
+dynamic_array_get_copy (dynamic_array_t * p_array,
+                        size_t            index,
+                        void *            p_out)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_out))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (__atomic_load_n(&p_array->b_optimistic, __ATOMIC_ACQUIRE))
+    {
+        if (NULL == dynamic_array_read_optimistic(p_array, index, p_out))
+        {
+            fprintf(stderr, "Array index out of bounds.\n");
+            status = FAILURE;
+        }
+
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (p_array->size <= index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        status = FAILURE;
+    }
+    else
+    {
+        memcpy(p_out, dynamic_array_slot(p_array, index), p_array->elem_size);
+    }
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_enable_optimistic_reads (dynamic_array_t * p_array)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 <= p_array->fd)
+    {
+        fprintf(stderr, "File-backed arrays cannot be read optimistically.\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    __atomic_store_n(&p_array->b_optimistic, true, __ATOMIC_RELEASE);
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Waits out a grace period. Each round starts a new epoch, so that new
+ * reads count themselves in the other counter, and yields until the counter
+ * of the previous epoch drops to zero. Two rounds are needed because a read
+ * may load the epoch just before a flip and only then join the old counter;
+ * the second round waits for it. Reads that join after a round's fence load
+ * the buffer after it and so never see one retired before the call. The
+ * caller holds the write lock, which keeps grace periods from overlapping.
+ */
+static void
+dynamic_array_wait_readers (dynamic_array_t * p_array)
+{
+    for (int round = 0; round < 2; round++)
+    {
+        unsigned long epoch = __atomic_fetch_add(
+            &p_array->reclaim_epoch, 1, __ATOMIC_RELEASE);
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        while (0
+               != __atomic_load_n(&p_array->readers[epoch & 1],
+                                  __ATOMIC_ACQUIRE))
+        {
+            sched_yield();
+        }
+    }
+}
+
+int
+dynamic_array_reclaim (dynamic_array_t * p_array)
+{
+    int status = SUCCESS;
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
     {
-        fprintf(stderr, "Provided NULL function pointers to array.\n");
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
         goto EXIT;
     }
 
-    p_array = calloc(1, sizeof(dynamic_array_t));
+    if (0 < p_array->num_retired)
+    {
+        dynamic_array_wait_readers(p_array);
+        dynamic_array_free_retired(p_array);
+    }
+
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return status;
+}
+
+int
+dynamic_array_sync (dynamic_array_t * p_array)
+{
+    int status = SUCCESS;
 
     if (NULL == p_array)
     {
-        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
         goto EXIT;
     }
 
-    if (0 != pthread_rwlock_init(&p_array->array_lock, NULL))
+    if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
     {
-        fprintf(stderr, "Dynamic array lock initialization failed.\n");
-        free(p_array);
-        p_array = NULL;
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
         goto EXIT;
     }
 
-    p_array->pp_data = calloc(capacity, sizeof(void *));
+    if (0 > p_array->fd)
+    {
+        fprintf(stderr, "Dynamic array is not file-backed.\n");
+        status = FAILURE;
+        goto EXIT_UNLOCK;
+    }
+
+    ((dynamic_array_file_header_t *)p_array->p_map)->size = p_array->size;
 
-    if (NULL == p_array->pp_data)
+    if (0 != msync(p_array->p_map, p_array->map_size, MS_SYNC))
     {
-        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
-        free(p_array);
-        p_array = NULL;
-        goto EXIT;
+        fprintf(stderr, "Failed to sync the array file.\n");
+        status = FAILURE;
     }
 
-    p_array->size               = 0;
-    p_array->capacity           = capacity;
-    p_array->bp_compare         = bp_compare;
-    p_array->p_destroy_function = p_destroy;
+EXIT_UNLOCK:
+    pthread_rwlock_unlock(&p_array->array_lock);
 
 EXIT:
-    return p_array;
+    return status;
 }
 
-void
-dynamic_array_destroy (dynamic_array_t * p_array)
+void *
+dynamic_array_at (dynamic_array_t * p_array, size_t index)
 {
-    fprintf(stdout, "Cleaning up array...\n");
+    void * p_slot = NULL;
 
-    if (NULL == p_array)
+    if ((NULL == p_array) || (NULL == p_array->p_data))
     {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
         goto EXIT;
     }
 
-    pthread_rwlock_wrlock(&p_array->array_lock);
-
-    if (NULL != p_array->pp_data)
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
     {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
 
-        for (size_t index = 0; index < p_array->size; index++)
-        {
-            if (NULL != p_array->pp_data[index])
-            {
-                p_array->p_destroy_function(p_array->pp_data[index]);
-            }
-        }
-
-        free(p_array->pp_data);
-        p_array->pp_data = NULL;
+    if (p_array->size <= index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+    }
+    else
+    {
+        p_slot = dynamic_array_slot(p_array, index);
     }
 
     pthread_rwlock_unlock(&p_array->array_lock);
-    pthread_rwlock_destroy(&p_array->array_lock);
-
-    free(p_array);
-    p_array = NULL;
 
 EXIT:
-    return;
+    return p_slot;
 }
 
 int
-dynamic_array_resize (dynamic_array_t * p_array, size_t new_capacity)
+dynamic_array_search (dynamic_array_t * p_array, void * p_item)
 {
-    int status = SUCCESS;
+    int found_index = -1;
 
-    if ((NULL == p_array) || (NULL == p_array->pp_data))
+    if ((NULL == p_array) || (NULL == p_array->p_data)
+        || (NULL == p_array->bp_compare))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
-        status = FAILURE;
         goto EXIT;
     }
 
-    void ** pp_temp = realloc(
-        p_array->pp_data, new_capacity * p_array->capacity * sizeof(void *));
-
-    if (NULL == pp_temp)
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
     {
-        fprintf(stderr, "Memory reallocation error\n");
-        status = FAILURE;
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
         goto EXIT;
     }
 
-    p_array->pp_data  = pp_temp;
-    p_array->capacity = new_capacity;
+    for (size_t index = 0; index < p_array->size; index++)
+    {
+        if (p_array->bp_compare(dynamic_array_element(p_array, index), p_item))
+        {
+            found_index = index;
+            break;
+        }
+    }
+
+    pthread_rwlock_unlock(&p_array->array_lock);
 
 EXIT:
-    return status;
+    return found_index;
+}
+
+/**
+ * @brief Adapts the array's ordering function, which receives elements the
+ * way the other callbacks do, to the slot addresses the sort works on.
+ */
+static int
+dynamic_array_order_slots (const void * p_left,
+                           const void * p_right,
+                           void *       p_context)
+{
+    const dynamic_array_t * p_array = (const dynamic_array_t *)p_context;
+    void *                  p_first  = (void *)p_left;
+    void *                  p_second = (void *)p_right;
+
+    if (!p_array->b_inline)
+    {
+        p_first  = *(void * const *)p_left;
+        p_second = *(void * const *)p_right;
+    }
+
+    return p_array->p_order(p_first, p_second);
 }
 
 int
-dynamic_array_insert (dynamic_array_t * p_array, void * p_element)
+dynamic_array_sort (dynamic_array_t * p_array,
+                    int (*p_order)(void *, void *),
+                    struct threadpool_t * p_pool)
 {
     int status = SUCCESS;
 
-    if ((NULL == p_array) || (NULL == p_array->pp_data))
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_order))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
         status = FAILURE;
         goto EXIT;
     }
 
+    // Writers wait for the whole sort, but optimistic readers only for the
+    // swap: they keep reading the unsorted buffer while a copy is sorted
     if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
@@ -133,19 +1558,55 @@ dynamic_array_insert (dynamic_array_t * p_array, void * p_element)
         goto EXIT;
     }
 
-    if (p_array->size >= p_array->capacity)
+    uint8_t * p_sorted = p_array->p_data;
+
+    if (p_array->b_optimistic)
     {
-        size_t new_capacity = DOUBLE * p_array->capacity;
-        status              = dynamic_array_resize(p_array, new_capacity);
+        p_sorted = NULL;
+
+        if (SUCCESS == dynamic_array_reserve_retired(p_array))
+        {
+            p_sorted = malloc(p_array->capacity * p_array->elem_size);
+        }
 
-        if (SUCCESS != status)
+        if (NULL == p_sorted)
         {
+            fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+            status = FAILURE;
             goto EXIT_UNLOCK;
         }
+
+        memcpy(p_sorted, p_array->p_data, p_array->size * p_array->elem_size);
+    }
+
+    // Read by dynamic_array_order_slots() during the sort
+    p_array->p_order = p_order;
+
+    if (0
+        != parallel_sort(p_pool,
+                         p_sorted,
+                         p_array->size,
+                         p_array->elem_size,
+                         dynamic_array_order_slots,
+                         p_array))
+    {
+        if (p_sorted != p_array->p_data)
+        {
+            free(p_sorted);
+        }
+
+        status = FAILURE;
+        goto EXIT_UNLOCK;
     }
 
-    p_array->pp_data[p_array->size] = p_element;
-    p_array->size++;
+    if (p_sorted != p_array->p_data)
+    {
+        dynamic_array_write_begin(p_array);
+        dynamic_array_replace_unlocked(p_array, p_sorted, p_array->capacity);
+        dynamic_array_write_end(p_array);
+    }
+
+    p_array->b_sorted = true;
 
 EXIT_UNLOCK:
     pthread_rwlock_unlock(&p_array->array_lock);
@@ -155,98 +1616,240 @@ EXIT:
 }
 
 int
-dynamic_array_remove (dynamic_array_t * p_array, size_t index)
+dynamic_array_bsearch (dynamic_array_t * p_array, void * p_key)
 {
-    int status = SUCCESS;
+    int found_index = -1;
 
-    if ((NULL == p_array) || (NULL == p_array->pp_data))
+    if ((NULL == p_array) || (NULL == p_array->p_data))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
-        status = FAILURE;
         goto EXIT;
     }
 
-    if (0 != pthread_rwlock_wrlock(&p_array->array_lock))
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
-        status = FAILURE;
         goto EXIT;
     }
 
-    if (p_array->size <= index)
+    if (!p_array->b_sorted)
     {
-        fprintf(stderr, "Array index out of bounds.\n");
-        status = FAILURE;
+        fprintf(stderr, "Array is not sorted.\n");
         goto EXIT_UNLOCK;
     }
 
-    p_array->p_destroy_function(p_array->pp_data[index]);
+    size_t low  = 0;
+    size_t high = p_array->size;
+
+    // Lower bound, so the first of several equal elements is found
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (0 > p_array->p_order(dynamic_array_element(p_array, middle), p_key))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
 
-    for (size_t count = index; count < p_array->size - 1; count++)
+    if ((low < p_array->size)
+        && (0 == p_array->p_order(dynamic_array_element(p_array, low), p_key)))
     {
-        p_array->pp_data[count] = p_array->pp_data[count + 1];
+        found_index = low;
     }
 
-    p_array->size--;
+EXIT_UNLOCK:
+    pthread_rwlock_unlock(&p_array->array_lock);
+
+EXIT:
+    return found_index;
+}
+
+int
+dynamic_array_find (dynamic_array_t * p_array, const void * p_key)
+{
+    int found_index = -1;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
 
-    if (p_array->size < (p_array->size / ARRAY_SIZE_DIVISOR))
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
     {
-        size_t new_capacity = p_array->size / ARRAY_SIZE_DIVISOR;
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
 
-        status = dynamic_array_resize(p_array, new_capacity);
+    size_t    size   = p_array->size;
+    size_t    index  = size;
+    uint8_t * p_data = p_array->p_data;
 
-        if (SUCCESS != status)
-        {
-            goto EXIT_UNLOCK;
-        }
+    switch (p_array->elem_size)
+    {
+        case sizeof(uint8_t):
+            index = dynamic_array_scan_8(
+                p_data, size, *(const uint8_t *)p_key);
+            break;
+        case sizeof(uint16_t):
+            index = dynamic_array_scan_16((dynamic_array_u16_t *)p_data,
+                                          size,
+                                          *(const dynamic_array_u16_t *)p_key);
+            break;
+        case sizeof(uint32_t):
+            index = dynamic_array_scan_32((dynamic_array_u32_t *)p_data,
+                                          size,
+                                          *(const dynamic_array_u32_t *)p_key);
+            break;
+        case sizeof(uint64_t):
+            index = dynamic_array_scan_64((dynamic_array_u64_t *)p_data,
+                                          size,
+                                          *(const dynamic_array_u64_t *)p_key);
+            break;
+        default:
+            for (index = 0; index < size; index++)
+            {
+                if (0
+                    == memcmp(dynamic_array_slot(p_array, index),
+                              p_key,
+                              p_array->elem_size))
+                {
+                    break;
+                }
+            }
+            break;
+    }
 
-        p_array->capacity = new_capacity;
+    if (index < size)
+    {
+        found_index = index;
     }
 
-EXIT_UNLOCK:
     pthread_rwlock_unlock(&p_array->array_lock);
 
+EXIT:
+    return found_index;
+}
+
+int
+dynamic_array_cursor_open (dynamic_array_t *        p_array,
+                           dynamic_array_cursor_t * p_cursor)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_cursor))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_cursor->b_open = false;
+
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_cursor->p_array  = p_array;
+    p_cursor->position = 0;
+    p_cursor->size     = p_array->size;
+    p_cursor->b_open   = true;
+
 EXIT:
     return status;
 }
 
-void *
-dynamic_array_get_element (dynamic_array_t * p_array, size_t index)
+size_t
+dynamic_array_cursor_next (dynamic_array_cursor_t * p_cursor,
+                           size_t                   max_count,
+                           void **                  pp_span)
 {
-    void * p_item = NULL;
+    size_t count = 0;
+
+    if ((NULL == p_cursor) || (NULL == pp_span) || !p_cursor->b_open)
+    {
+        goto EXIT;
+    }
+
+    count = p_cursor->size - p_cursor->position;
+
+    if ((0 != max_count) && (max_count < count))
+    {
+        count = max_count;
+    }
+
+    *pp_span = dynamic_array_slot(p_cursor->p_array, p_cursor->position);
+    p_cursor->position += count;
+
+EXIT:
+    return count;
+}
+
+void
+dynamic_array_cursor_close (dynamic_array_cursor_t * p_cursor)
+{
+    if ((NULL != p_cursor) && p_cursor->b_open)
+    {
+        pthread_rwlock_unlock(&p_cursor->p_array->array_lock);
+        p_cursor->b_open = false;
+    }
+}
+
+int
+dynamic_array_for_each (dynamic_array_t * p_array,
+                        bool (*p_visit)(void * p_element, void * p_context),
+                        void * p_context)
+{
+    int status = SUCCESS;
 
-    if ((NULL == p_array) || (NULL == p_array->pp_data))
+    if ((NULL == p_array) || (NULL == p_array->p_data) || (NULL == p_visit))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
         goto EXIT;
     }
 
-    if (0 == pthread_rwlock_rdlock(&p_array->array_lock))
+    if (0 != pthread_rwlock_rdlock(&p_array->array_lock))
     {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
 
-        if (p_array->size <= index)
-        {
-            fprintf(stderr, "Array index out of bounds.\n");
-        }
-        else
+    for (size_t index = 0; index < p_array->size; index++)
+    {
+        if (!p_visit(dynamic_array_element(p_array, index), p_context))
         {
-            p_item = p_array->pp_data[index];
+            break;
         }
     }
 
     pthread_rwlock_unlock(&p_array->array_lock);
 
 EXIT:
-    return p_item;
+    return status;
 }
 
-int
-dynamic_array_search (dynamic_array_t * p_array, void * p_item)
+dynamic_array_t *
+dynamic_array_map (dynamic_array_t * p_array,
+                   size_t            out_elem_size,
+                   void (*p_function)(void * p_element,
+                                      void * p_out,
+                                      void * p_context),
+                   void * p_context)
 {
-    int found_index = -1;
+    dynamic_array_t * p_result = NULL;
 
-    if ((NULL == p_array) || (NULL == p_array->pp_data)
-        || (NULL == p_array->bp_compare))
+    if ((NULL == p_array) || (NULL == p_array->p_data)
+        || (NULL == p_function) || (0 == out_elem_size))
     {
         fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
         goto EXIT;
@@ -258,19 +1861,25 @@ dynamic_array_search (dynamic_array_t * p_array, void * p_item)
         goto EXIT;
     }
 
-    for (size_t index = 0; index < p_array->size; index++)
+    p_result = dynamic_array_create(
+        p_array->size, out_elem_size, true, NULL, NULL);
+
+    if (NULL != p_result)
     {
-        if (p_array->bp_compare(p_array->pp_data[index], p_item))
+        for (size_t index = 0; index < p_array->size; index++)
         {
-            found_index = index;
-            break;
+            p_function(dynamic_array_element(p_array, index),
+                       dynamic_array_slot(p_result, index),
+                       p_context);
         }
+
+        p_result->size = p_array->size;
     }
 
     pthread_rwlock_unlock(&p_array->array_lock);
 
 EXIT:
-    return found_index;
+    return p_result;
 }
 
 // End of dynamic_array.c
@@ -11,6 +11,8 @@
 
 #include "common.h"
 
+struct threadpool_t;
+
 /**
  * @brief Defines the initial starting capacity at array creation
  *
@@ -24,28 +26,114 @@
  */
 #define ARRAY_SIZE_DIVISOR 2
 
+/**
+ * @brief Defines how far below capacity the size must fall before the array
+ * shrinks. Shrinking to capacity / ARRAY_SIZE_DIVISOR only once the size drops
+ * below capacity / ARRAY_SHRINK_THRESHOLD leaves room on both sides, so
+ * alternating inserts and removals never resize on every call.
+ *
+ */
+#define ARRAY_SHRINK_THRESHOLD 4
+
+/**
+ * @brief Defines the default growth factor, as a fraction, applied to the
+ * capacity when a full array needs room
+ *
+ */
+#define ARRAY_GROWTH_NUMERATOR   2
+#define ARRAY_GROWTH_DENOMINATOR 1
+
+/**
+ * @brief Defines the magic number opening the file of a file-backed array,
+ * "DYNARRAY" read as a little-endian integer
+ *
+ */
+#define DYNAMIC_ARRAY_FILE_MAGIC 0x59415252414E5944ULL
+
+/**
+ * @brief Header at the start of the file of a file-backed array. The
+ * elements follow it directly, so element i sits at byte offset
+ * sizeof(dynamic_array_file_header_t) + (i * elem_size).
+ *
+ */
+typedef struct dynamic_array_file_header_t
+{
+    uint64_t magic;       /**< DYNAMIC_ARRAY_FILE_MAGIC */
+    uint64_t elem_size;   /**< Size in bytes of each element */
+    uint64_t size;        /**< Number of elements as of the last sync */
+    uint64_t reserved[5]; /**< Pads the header to 64 bytes */
+} dynamic_array_file_header_t;
+
 /**
  * @brief Structure representing a dynamic array.
  *
+ * Elements live contiguously in p_data, elem_size bytes each. Arrays made by
+ * dynamic_array_init() store one pointer per element; arrays made by
+ * dynamic_array_init_sized() store the elements themselves (inline), so small
+ * structures need no allocation of their own. Arrays made by
+ * dynamic_array_init_mapped() store their elements inline in a shared mapping
+ * of a file, behind a dynamic_array_file_header_t.
+ *
+ * Writers always take array_lock. After
+ * dynamic_array_enable_optimistic_reads(), indexed reads take no lock at all:
+ * they read under the sequence counter and retry if a writer intervened.
+ * Each such read is counted in readers for the epoch it started in, so
+ * dynamic_array_reclaim() can wait for the reads that may still see a
+ * retired buffer.
+ *
  */
 typedef struct dynamic_array_t
 {
     pthread_rwlock_t array_lock; /**< Read-write lock for thread-safe access
                                                  to array. */
-    void ** pp_data;             /**< Pointer to the array data */
-    size_t  size;                /**< Current number of elements in the array */
-    size_t  capacity;            /**< Current capacity of the array */
+    uint8_t * p_data;     /**< Pointer to the element storage */
+    size_t    elem_size;  /**< Size in bytes of each element slot */
+    bool      b_inline;   /**< Whether elements are stored by value */
+    size_t    size;       /**< Current number of elements in the array */
+    size_t    capacity;   /**< Current capacity of the array */
+    size_t growth_numerator;   /**< Numerator of the growth factor */
+    size_t growth_denominator; /**< Denominator of the growth factor */
+    bool   b_optimistic;  /**< Whether readers skip the lock (seqlock mode) */
+    unsigned long sequence; /**< Seqlock counter, odd while a writer is
+                                 modifying an optimistic array */
+    uint8_t ** pp_retired;  /**< Replaced buffers optimistic readers may still
+                                 be reading */
+    size_t num_retired;      /**< Number of entries in pp_retired */
+    size_t retired_capacity; /**< Capacity of pp_retired */
+    unsigned long reclaim_epoch; /**< Count of grace periods; its parity
+                                      selects the reader counter to join */
+    unsigned long readers[2]; /**< Optimistic reads in progress, by epoch
+                                   parity */
     bool (*bp_compare)(
         void *, void *); /**< Pointer to the comparison function for elements */
     void (*p_destroy_function)(
         void *); /**< Pointer to the function used to destroy elements */
+    int (*p_order)(void *, void *); /**< Ordering function of the last sort */
+    bool b_sorted; /**< Whether the elements are ordered by p_order */
+    int       fd;       /**< Backing file, or -1 for heap storage */
+    uint8_t * p_map;    /**< Start of the file mapping (the header) */
+    size_t    map_size; /**< Length in bytes of the file and its mapping */
 } dynamic_array_t;
 
+/**
+ * @brief A read cursor over a dynamic array. While open it holds the array's
+ * read lock, so the elements it hands out stay in place and writers wait.
+ *
+ */
+typedef struct dynamic_array_cursor_t
+{
+    dynamic_array_t * p_array;  /**< Array being traversed */
+    size_t            position; /**< Index of the next element to return */
+    size_t            size;     /**< Size of the array when opened */
+    bool              b_open;   /**< Whether the cursor holds the lock */
+} dynamic_array_cursor_t;
+
 /**
  * @brief Initialize a dynamic array with the given capacity, comparison
  * function, and destroy function.
  *
- * @param capacity The initial capacity of the array.
+ * @param capacity The initial capacity of the array, or 0 for
+ * INITIAL_ARRAY_CAPACITY.
  * @param bp_compare Pointer to the comparison function for elements.
  * @param p_destroy Pointer to the function used to destroy elements.
  * @return A pointer to the newly created dynamic array, or NULL if
@@ -58,7 +146,66 @@ dynamic_array_t * dynamic_array_init (size_t capacity,
                                       void (*p_destroy)(void *));
 
 /**
- * @brief Frees the memory allocated for the array and its data.
+ * @brief Initialize a dynamic array storing elements of elem_size bytes
+ * inline.
+ *
+ * The comparison and destroy functions receive pointers to the elements
+ * inside the array. Both are optional: without a comparison function
+ * dynamic_array_search() fails, and without a destroy function removed
+ * elements are simply overwritten.
+ *
+ * @param capacity The initial capacity of the array, or 0 for
+ * INITIAL_ARRAY_CAPACITY.
+ * @param elem_size Size in bytes of one element.
+ * @param bp_compare Pointer to the comparison function for elements, or NULL.
+ * @param p_destroy Pointer to the function used to destroy elements, or NULL.
+ * @return A pointer to the newly created dynamic array, or NULL if
+ * initialization fails.
+ * @warning Returns NULL in the event of memory allocation failure, lock
+ * initialization failure, or an elem_size of 0.
+ */
+dynamic_array_t * dynamic_array_init_sized (size_t capacity,
+                                            size_t elem_size,
+                                            bool (*bp_compare)(void *, void *),
+                                            void (*p_destroy)(void *));
+
+/**
+ * @brief Open or create a file-backed array of elements of elem_size bytes.
+ *
+ * The file is mapped shared, so the operating system pages elements in on
+ * access and writes them back on its own schedule; the array may be larger
+ * than physical memory and needs no load phase. Growing or shrinking the
+ * array resizes the file with ftruncate() and the mapping with mremap().
+ * Reopening the file restores the elements as of the last
+ * dynamic_array_sync() or dynamic_array_destroy().
+ *
+ * Elements must be plain data: pointers stored in them do not survive a
+ * restart. The destroy function runs on removal only, never at
+ * dynamic_array_destroy(), because the elements outlive the process.
+ *
+ * @param p_path Path of the backing file, created if it does not exist.
+ * @param capacity The initial capacity of a new file, or 0 for
+ * INITIAL_ARRAY_CAPACITY. Ignored when the file already exists.
+ * @param elem_size Size in bytes of one element.
+ * @param bp_compare Pointer to the comparison function for elements, or NULL.
+ * @param p_destroy Pointer to the function used to destroy elements, or NULL.
+ * @return A pointer to the newly created dynamic array, or NULL if
+ * initialization fails.
+ * @warning Returns NULL in the event of memory allocation failure, lock
+ * initialization failure, an elem_size of 0, a file that cannot be opened or
+ * mapped, or an existing file that is not an array of elem_size elements.
+ */
+dynamic_array_t * dynamic_array_init_mapped (const char * p_path,
+                                             size_t       capacity,
+                                             size_t       elem_size,
+                                             bool (*bp_compare)(void *,
+                                                                void *),
+                                             void (*p_destroy)(void *));
+
+/**
+ * @brief Frees the memory allocated for the array and its data. File-backed
+ * arrays are synced, unmapped and closed instead; their elements stay in the
+ * file.
  *
  * @param p_hashtable A pointer to the dynamic array.
  */
@@ -70,13 +217,56 @@ void dynamic_array_destroy (dynamic_array_t * p_array);
  * @param p_array Pointer to the dynamic array to be resized.
  * @param new_capacity The new capacity of the array.
  * @return SUCCESS on success, FAILURE on failure.
- * @warning Returns FAILURE in the event of NULL pointer inputs
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * a capacity smaller than the current size or of 0, or memory reallocation
+ * failure.
  */
 int dynamic_array_resize (dynamic_array_t * p_array, size_t new_capacity);
 
+/**
+ * @brief Set the factor the capacity is multiplied by when a full array
+ * grows. The factor must be greater than 1; the default is
+ * ARRAY_GROWTH_NUMERATOR / ARRAY_GROWTH_DENOMINATOR.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param numerator Numerator of the growth factor.
+ * @param denominator Denominator of the growth factor.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or a factor of 1 or less.
+ */
+int dynamic_array_set_growth (dynamic_array_t * p_array,
+                              size_t            numerator,
+                              size_t            denominator);
+
+/**
+ * @brief Ensure the array can hold at least min_capacity elements without
+ * reallocating.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param min_capacity The capacity required.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or memory reallocation failure.
+ */
+int dynamic_array_reserve (dynamic_array_t * p_array, size_t min_capacity);
+
+/**
+ * @brief Reduce the capacity of the array to its size, or to 1 when empty.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or memory reallocation failure.
+ */
+int dynamic_array_shrink_to_fit (dynamic_array_t * p_array);
+
 /**
  * @brief Insert an element into the dynamic array.
  *
+ * Pointer arrays store p_element itself; inline arrays copy elem_size bytes
+ * from it, as dynamic_array_push() does.
+ *
  * @param p_array Pointer to the dynamic array.
  * @param p_element Pointer to the element to be inserted.
  * @return SUCCESS on success, FAILURE on failure.
@@ -85,6 +275,18 @@ int dynamic_array_resize (dynamic_array_t * p_array, size_t new_capacity);
  */
 int dynamic_array_insert (dynamic_array_t * p_array, void * p_element);
 
+/**
+ * @brief Append a copy of the elem_size bytes at p_element to the array. For
+ * pointer arrays, p_element is the address of the pointer to store.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_element Pointer to the bytes to copy.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or resize failure.
+ */
+int dynamic_array_push (dynamic_array_t * p_array, const void * p_element);
+
 /**
  * @brief Remove an element from the dynamic array at the specified index.
  *
@@ -92,21 +294,165 @@ int dynamic_array_insert (dynamic_array_t * p_array, void * p_element);
  * @param index The index of the element to be removed.
  * @return SUCCESS on success, FAILURE on failure.
  * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
- * or resize failure.
+ * or index out of bounds error. Failing to shrink the array is not an error.
  */
 int dynamic_array_remove (dynamic_array_t * p_array, size_t index);
 
+/**
+ * @brief Append count elements in one operation, taking the lock and
+ * reallocating at most once.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_elements Contiguous elements of elem_size bytes each; an array of
+ * pointers for pointer arrays.
+ * @param count Number of elements to append. With 0, p_elements may be NULL
+ * and the array is left untouched.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or resize failure.
+ */
+int dynamic_array_append_range (dynamic_array_t * p_array,
+                                const void *      p_elements,
+                                size_t            count);
+
+/**
+ * @brief Insert an element before the specified index, shifting later
+ * elements up. An index equal to the size appends.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param index The index the element will have.
+ * @param p_element Pointer to the element, treated as by
+ * dynamic_array_insert().
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * index out of bounds error, or resize failure.
+ */
+int dynamic_array_insert_at (dynamic_array_t * p_array,
+                             size_t            index,
+                             void *            p_element);
+
+/**
+ * @brief Remove count elements starting at the specified index, closing the
+ * gap with a single move.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param index The index of the first element to remove.
+ * @param count Number of elements to remove.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or a range extending past the end of the array.
+ */
+int dynamic_array_erase_range (dynamic_array_t * p_array,
+                               size_t            index,
+                               size_t            count);
+
+/**
+ * @brief Remove the element at the specified index in constant time by
+ * moving the last element into its place. Element order is not preserved.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param index The index of the element to be removed.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or index out of bounds error.
+ */
+int dynamic_array_swap_remove (dynamic_array_t * p_array, size_t index);
+
 /**
  * @brief Get the element at the specified index in the dynamic array.
  *
  * @param p_array Pointer to the dynamic array.
  * @param index The index of the element to retrieve.
- * @return A pointer to the element at the specified index, or NULL.
+ * @return The stored pointer for pointer arrays, or the element's address
+ * for inline arrays, as dynamic_array_at() returns.
  * @warning Returns NULL in the event of NULL pointer inputs, lock failure, or
- * index out of bounds error.
+ * index out of bounds error. For an optimistic inline array the address may
+ * lie in a retired buffer, which dynamic_array_reclaim() frees.
  */
 void * dynamic_array_get_element (dynamic_array_t * p_array, size_t index);
 
+/**
+ * @brief Copy the element at the specified index into p_out. This is the safe
+ * way to read inline elements concurrently with writers. On an optimistic
+ * array the copy is taken within a read that dynamic_array_reclaim() waits
+ * for, so it may run concurrently with reclaim too.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param index The index of the element.
+ * @param p_out Destination for elem_size bytes; for pointer arrays, the
+ * address of a pointer.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * or index out of bounds error.
+ */
+int dynamic_array_get_copy (dynamic_array_t * p_array,
+                            size_t            index,
+                            void *            p_out);
+
+/**
+ * @brief Switch the array to optimistic reads. dynamic_array_get_element()
+ * and dynamic_array_get_copy() then read without locking and retry while a
+ * writer is active, so read-heavy loops scale across cores.
+ *
+ * In this mode a growing array copies into a new buffer and retires the old
+ * one instead of reallocating it, and the capacity never shrinks.
+ * Readers spin for as long as a writer is modifying the array, which for
+ * most writers is one copy or move of the elements; dynamic_array_sort()
+ * sorts a copy and holds readers off only while swapping it in.
+ * Retired buffers are freed by dynamic_array_reclaim(), which first waits
+ * for the optimistic reads in progress, or by dynamic_array_destroy(). The
+ * mode cannot be turned off.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock
+ * failure, or a file-backed array, whose mapping may move when it grows.
+ * Pointers returned by dynamic_array_get_element() for inline arrays may
+ * refer to a retired buffer and are only valid until the next
+ * dynamic_array_reclaim(); use dynamic_array_get_copy().
+ */
+int dynamic_array_enable_optimistic_reads (dynamic_array_t * p_array);
+
+/**
+ * @brief Free the buffers retired by growth in optimistic mode.
+ *
+ * Waits for a grace period first: every optimistic read that started before
+ * the call, and so may still be reading a retired buffer, finishes before
+ * anything is freed. Reads that start later see only the current buffer, so
+ * readers may keep running throughout; writers wait for the call to return.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or lock
+ * failure. Element addresses handed out by dynamic_array_get_element() for
+ * an optimistic inline array may be freed by this call.
+ */
+int dynamic_array_reclaim (dynamic_array_t * p_array);
+
+/**
+ * @brief Record the size of a file-backed array in its header and write the
+ * header and every modified element to the file before returning.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock failure,
+ * an array that is not file-backed, or msync() failure.
+ */
+int dynamic_array_sync (dynamic_array_t * p_array);
+
+/**
+ * @brief Get the address of the slot holding the element at the specified
+ * index.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param index The index of the element.
+ * @return A pointer to elem_size bytes inside the array, or NULL.
+ * @warning Returns NULL in the event of NULL pointer inputs, lock failure, or
+ * index out of bounds error. The address is invalidated by any call that
+ * inserts, removes, or resizes.
+ */
+void * dynamic_array_at (dynamic_array_t * p_array, size_t index);
+
 /**
  * @brief Search for an item in the dynamic array using the search function
  * provided at initialization
@@ -119,6 +465,133 @@ void * dynamic_array_get_element (dynamic_array_t * p_array, size_t index);
  */
 int dynamic_array_search (dynamic_array_t * p_array, void * p_item);
 
+/**
+ * @brief Sort the array and put it in sorted mode for dynamic_array_bsearch().
+ *
+ * Runs are sorted and merged on p_pool when it is given and the array is
+ * large enough; otherwise, and when called from one of p_pool's workers, the
+ * calling thread sorts. Sorted mode ends with the next insertion or
+ * swap_remove; removals keep it. The sort is not stable.
+ *
+ * Writers wait for the whole sort. An optimistic array is sorted in a copy
+ * that then replaces the buffer, which is retired as growth retires it, so
+ * optimistic readers keep reading the unsorted elements meanwhile and only
+ * retry across the swap.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_order Ordering function returning a negative, zero or positive
+ * value; it receives elements as the comparison function does.
+ * @param p_pool Thread pool to sort on, or NULL.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, lock
+ * failure, or, for an optimistic array, memory allocation failure. Elements
+ * changed in place through dynamic_array_at() are not noticed by sorted mode.
+ */
+int dynamic_array_sort (dynamic_array_t * p_array,
+                        int (*p_order)(void *, void *),
+                        struct threadpool_t * p_pool);
+
+/**
+ * @brief Binary search of a sorted array.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_key Key passed as the second argument of the ordering function.
+ * @return The index of the first element ordered equal to p_key, or -1 if
+ * not found.
+ * @warning Returns -1 in the event of NULL pointer inputs, lock failure, or
+ * an array not in sorted mode.
+ */
+int dynamic_array_bsearch (dynamic_array_t * p_array, void * p_key);
+
+/**
+ * @brief Search for an element whose bytes equal those at p_key, without
+ * calling the comparison function. Arrays of 1, 2, 4 or 8-byte elements,
+ * which includes every pointer array, are scanned in blocks the compiler
+ * vectorizes.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_key Pointer to elem_size bytes; for pointer arrays, the address
+ * of the pointer to look for.
+ * @return The index of the first matching element, or -1 if not found.
+ * @warning Returns -1 in the event of NULL pointer inputs or lock failure.
+ */
+int dynamic_array_find (dynamic_array_t * p_array, const void * p_key);
+
+/**
+ * @brief Open a read cursor at the start of the array, taking the read lock
+ * once for the whole traversal.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_cursor Pointer to the cursor to open.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or lock
+ * failure. The calling thread must close the cursor before writing to the
+ * array.
+ */
+int dynamic_array_cursor_open (dynamic_array_t *        p_array,
+                               dynamic_array_cursor_t * p_cursor);
+
+/**
+ * @brief Return the next contiguous span of elements and advance past it.
+ *
+ * The span is the array's own storage: elem_size bytes per element, so an
+ * array of void * for pointer arrays.
+ *
+ * @param p_cursor Pointer to an open cursor.
+ * @param max_count Largest number of elements to return, or 0 for all that
+ * remain.
+ * @param pp_span Receives the address of the first element of the span.
+ * @return The number of elements in the span, or 0 at the end of the array.
+ * @warning Returns 0 in the event of NULL pointer inputs or a closed cursor.
+ */
+size_t dynamic_array_cursor_next (dynamic_array_cursor_t * p_cursor,
+                                  size_t                   max_count,
+                                  void **                  pp_span);
+
+/**
+ * @brief Close a cursor and release the read lock.
+ *
+ * @param p_cursor Pointer to the cursor.
+ */
+void dynamic_array_cursor_close (dynamic_array_cursor_t * p_cursor);
+
+/**
+ * @brief Call p_visit on every element in order, under one read lock.
+ *
+ * @param p_array Pointer to the dynamic array.
+ * @param p_visit Function receiving each element, as the comparison function
+ * does, and p_context. Returning false stops the traversal.
+ * @param p_context Argument passed to every call.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or lock
+ * failure. p_visit must not write to the array.
+ */
+int dynamic_array_for_each (dynamic_array_t * p_array,
+                            bool (*p_visit)(void * p_element, void * p_context),
+                            void * p_context);
+
+/**
+ * @brief Build a new inline array holding p_function's result for every
+ * element, reading the source under one read lock and reserving the result
+ * once.
+ *
+ * @param p_array Pointer to the source array.
+ * @param out_elem_size Size in bytes of each result element.
+ * @param p_function Function receiving a source element, as the comparison
+ * function does, the slot to fill, and p_context.
+ * @param p_context Argument passed to every call.
+ * @return A pointer to the new array, or NULL. Its comparison and destroy
+ * functions are NULL.
+ * @warning Returns NULL in the event of NULL pointer inputs, an
+ * out_elem_size of 0, lock failure, or memory allocation failure.
+ */
+dynamic_array_t * dynamic_array_map (dynamic_array_t * p_array,
+                                     size_t            out_elem_size,
+                                     void (*p_function)(void * p_element,
+                                                        void * p_out,
+                                                        void * p_context),
+                                     void * p_context);
+
 #endif /* DYNAMIC_ARRAY_H */
 
 // End of dynamic_array.h
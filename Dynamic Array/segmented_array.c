@@ -0,0 +1,252 @@
+#include "segmented_array.h"
+
+/**
+ * @brief Returns the block holding element index and the element's offset
+ * within it.
+ */
+static inline size_t
+segmented_array_block (size_t index, size_t * p_offset)
+{
+    size_t biased  = index + SEGMENTED_ARRAY_FIRST_BLOCK;
+    int    highest = 63 - __builtin_clzll((unsigned long long)biased);
+
+    *p_offset = biased - ((size_t)1 << highest);
+
+    return (size_t)highest - SEGMENTED_ARRAY_FIRST_BLOCK_BITS;
+}
+
+/**
+ * @brief Returns the capacity of the first num_blocks blocks.
+ */
+static inline size_t
+segmented_array_capacity (size_t num_blocks)
+{
+    return (SEGMENTED_ARRAY_FIRST_BLOCK << num_blocks)
+           - SEGMENTED_ARRAY_FIRST_BLOCK;
+}
+
+/**
+ * @brief Allocates and publishes the next block. The caller holds the write
+ * lock.
+ */
+static int
+segmented_array_add_block (segmented_array_t * p_array)
+{
+    int       status  = SUCCESS;
+    size_t    block   = p_array->num_blocks;
+    size_t    count   = SEGMENTED_ARRAY_FIRST_BLOCK << block;
+    uint8_t * p_block = NULL;
+
+    if ((SEGMENTED_ARRAY_MAX_BLOCKS <= block)
+        || ((SIZE_MAX / p_array->elem_size) < count))
+    {
+        fprintf(stderr, "Segmented array is full.\n");
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_block = malloc(count * p_array->elem_size);
+
+    if (NULL == p_block)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    __atomic_store_n(&p_array->p_blocks[block], p_block, __ATOMIC_RELEASE);
+    p_array->num_blocks++;
+
+EXIT:
+    return status;
+}
+
+segmented_array_t *
+segmented_array_init (size_t elem_size, void (*p_destroy)(void *))
+{
+    segmented_array_t * p_array = NULL;
+
+    if (0 == elem_size)
+    {
+        fprintf(stderr, "Segmented array element size must not be 0.\n");
+        goto EXIT;
+    }
+
+    p_array = calloc(1, sizeof(segmented_array_t));
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (0 != pthread_mutex_init(&p_array->write_lock, NULL))
+    {
+        fprintf(stderr, "Segmented array lock initialization failed.\n");
+        free(p_array);
+        p_array = NULL;
+        goto EXIT;
+    }
+
+    p_array->num_blocks         = 0;
+    p_array->size               = 0;
+    p_array->elem_size          = elem_size;
+    p_array->p_destroy_function = p_destroy;
+
+EXIT:
+    return p_array;
+}
+
+void
+segmented_array_destroy (segmented_array_t * p_array)
+{
+    if (NULL == p_array)
+    {
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_array->write_lock);
+
+    for (size_t index = 0;
+         (NULL != p_array->p_destroy_function) && (index < p_array->size);
+         index++)
+    {
+        size_t offset = 0;
+        size_t block  = segmented_array_block(index, &offset);
+
+        p_array->p_destroy_function(p_array->p_blocks[block]
+                                    + (offset * p_array->elem_size));
+    }
+
+    for (size_t block = 0; block < p_array->num_blocks; block++)
+    {
+        free(p_array->p_blocks[block]);
+        p_array->p_blocks[block] = NULL;
+    }
+
+    pthread_mutex_unlock(&p_array->write_lock);
+    pthread_mutex_destroy(&p_array->write_lock);
+
+    free(p_array);
+    p_array = NULL;
+
+EXIT:
+    return;
+}
+
+int
+segmented_array_reserve (segmented_array_t * p_array, size_t capacity)
+{
+    int status = SUCCESS;
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_array->write_lock);
+
+    while ((SUCCESS == status)
+           && (segmented_array_capacity(p_array->num_blocks) < capacity))
+    {
+        status = segmented_array_add_block(p_array);
+    }
+
+    pthread_mutex_unlock(&p_array->write_lock);
+
+EXIT:
+    return status;
+}
+
+int
+segmented_array_push (segmented_array_t * p_array,
+                      const void *        p_element,
+                      size_t *            p_index)
+{
+    int status = SUCCESS;
+
+    if ((NULL == p_array) || (NULL == p_element))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_array->write_lock);
+
+    size_t index  = p_array->size;
+    size_t offset = 0;
+    size_t block  = segmented_array_block(index, &offset);
+
+    if (block >= p_array->num_blocks)
+    {
+        status = segmented_array_add_block(p_array);
+
+        if (SUCCESS != status)
+        {
+            goto EXIT_UNLOCK;
+        }
+    }
+
+    memcpy(p_array->p_blocks[block] + (offset * p_array->elem_size),
+           p_element,
+           p_array->elem_size);
+
+    // Readers that see the new size also see the element and its block
+    __atomic_store_n(&p_array->size, index + 1, __ATOMIC_RELEASE);
+
+    if (NULL != p_index)
+    {
+        *p_index = index;
+    }
+
+EXIT_UNLOCK:
+    pthread_mutex_unlock(&p_array->write_lock);
+
+EXIT:
+    return status;
+}
+
+void *
+segmented_array_at (segmented_array_t * p_array, size_t index)
+{
+    uint8_t * p_element = NULL;
+
+    if (NULL == p_array)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (__atomic_load_n(&p_array->size, __ATOMIC_ACQUIRE) <= index)
+    {
+        fprintf(stderr, "Array index out of bounds.\n");
+        goto EXIT;
+    }
+
+    size_t offset = 0;
+    size_t block  = segmented_array_block(index, &offset);
+
+    p_element = __atomic_load_n(&p_array->p_blocks[block], __ATOMIC_ACQUIRE)
+                + (offset * p_array->elem_size);
+
+EXIT:
+    return p_element;
+}
+
+size_t
+segmented_array_size (segmented_array_t * p_array)
+{
+    size_t size = 0;
+
+    if (NULL != p_array)
+    {
+        size = __atomic_load_n(&p_array->size, __ATOMIC_ACQUIRE);
+    }
+
+    return size;
+}
+
+// End of segmented_array.c
@@ -0,0 +1,125 @@
+/**
+ * @file segmented_array.h
+ * @author Taylor Bradley
+ * @brief Defines a segmented array whose elements never move, so growth
+ * copies nothing and element addresses stay valid.
+ * @date 2026-10-19
+ */
+
+#ifndef SEGMENTED_ARRAY_H
+#define SEGMENTED_ARRAY_H
+
+#include "common.h"
+
+/**
+ * @brief Defines the number of elements of the first block, as a power of two
+ *
+ */
+#define SEGMENTED_ARRAY_FIRST_BLOCK_BITS 4
+
+/**
+ * @brief Defines the number of elements of the first block
+ *
+ */
+#define SEGMENTED_ARRAY_FIRST_BLOCK \
+    ((size_t)1 << SEGMENTED_ARRAY_FIRST_BLOCK_BITS)
+
+/**
+ * @brief Defines the number of directory entries, enough for every index a
+ * size_t can hold
+ *
+ */
+#define SEGMENTED_ARRAY_MAX_BLOCKS (64 - SEGMENTED_ARRAY_FIRST_BLOCK_BITS)
+
+/**
+ * @brief Structure representing a segmented array.
+ *
+ * Block k holds SEGMENTED_ARRAY_FIRST_BLOCK << k elements, so the directory
+ * doubles the capacity with each block and never needs to grow itself.
+ * Element i lives in the block given by the highest set bit of
+ * i + SEGMENTED_ARRAY_FIRST_BLOCK. Writers serialize on write_lock; readers
+ * take no lock, because a block is published before the size that covers it
+ * and is never moved or freed until destroy.
+ *
+ */
+typedef struct segmented_array_t
+{
+    pthread_mutex_t write_lock; /**< Mutex serializing writers */
+    uint8_t * p_blocks[SEGMENTED_ARRAY_MAX_BLOCKS]; /**< Block directory */
+    size_t    num_blocks; /**< Number of allocated blocks */
+    size_t    size;       /**< Current number of elements in the array */
+    size_t    elem_size;  /**< Size in bytes of each element */
+    void (*p_destroy_function)(
+        void *); /**< Pointer to the function used to destroy elements */
+} segmented_array_t;
+
+/**
+ * @brief Initialize an empty segmented array.
+ *
+ * @param elem_size Size in bytes of one element.
+ * @param p_destroy Function receiving the address of each element at
+ * destroy, or NULL.
+ * @return A pointer to the newly created array, or NULL if initialization
+ * fails.
+ * @warning Returns NULL in the event of memory allocation failure, lock
+ * initialization failure, or an elem_size of 0.
+ */
+segmented_array_t * segmented_array_init (size_t elem_size,
+                                          void (*p_destroy)(void *));
+
+/**
+ * @brief Destroys every element and frees the array.
+ *
+ * @param p_array A pointer to the segmented array.
+ */
+void segmented_array_destroy (segmented_array_t * p_array);
+
+/**
+ * @brief Allocate blocks until the array can hold capacity elements.
+ *
+ * @param p_array Pointer to the segmented array.
+ * @param capacity The capacity required.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or memory
+ * allocation failure.
+ */
+int segmented_array_reserve (segmented_array_t * p_array, size_t capacity);
+
+/**
+ * @brief Append a copy of the elem_size bytes at p_element. Existing
+ * elements are neither copied nor moved.
+ *
+ * @param p_array Pointer to the segmented array.
+ * @param p_element Pointer to the bytes to copy.
+ * @param p_index Receives the index of the new element, may be NULL.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or memory
+ * allocation failure.
+ */
+int segmented_array_push (segmented_array_t * p_array,
+                          const void *        p_element,
+                          size_t *            p_index);
+
+/**
+ * @brief Get the address of the element at the specified index without
+ * locking. The address stays valid until the array is destroyed.
+ *
+ * @param p_array Pointer to the segmented array.
+ * @param index The index of the element.
+ * @return A pointer to the element, or NULL.
+ * @warning Returns NULL in the event of NULL pointer inputs or index out of
+ * bounds error.
+ */
+void * segmented_array_at (segmented_array_t * p_array, size_t index);
+
+/**
+ * @brief Get the number of elements, without locking.
+ *
+ * @param p_array Pointer to the segmented array.
+ * @return The number of elements, or 0 if p_array is NULL.
+ */
+size_t segmented_array_size (segmented_array_t * p_array);
+
+#endif /* SEGMENTED_ARRAY_H */
+
+// End of segmented_array.h
@@ -0,0 +1,692 @@
+#define _GNU_SOURCE
+#include "skiplist.h"
+#include <sched.h>
+
+/**
+ * @brief State of the random number generator choosing tower heights, one
+ * per thread so that inserting threads share nothing.
+ */
+static _Thread_local uint64_t g_skiplist_seed = 0;
+
+/**
+ * @brief Returns a tower height: level k with probability
+ * (1 / SKIPLIST_LEVEL_ODDS)^k.
+ */
+static int
+skiplist_random_level (void)
+{
+    uint64_t bits  = g_skiplist_seed;
+    int      level = 0;
+
+    if (0 == bits)
+    {
+        bits = ((uint64_t)(uintptr_t)&g_skiplist_seed * 0x9E3779B97F4A7C15ULL)
+               | 1;
+    }
+
+    bits ^= bits << 13;
+    bits ^= bits >> 7;
+    bits ^= bits << 17;
+    g_skiplist_seed = bits;
+
+    while (((SKIPLIST_MAX_LEVEL - 1) > level)
+           && (0 == (bits % SKIPLIST_LEVEL_ODDS)))
+    {
+        bits /= SKIPLIST_LEVEL_ODDS;
+        level++;
+    }
+
+    return level;
+}
+
+/**
+ * @brief Allocates a node with a tower of top_level + 1 pointers and room
+ * for a key after it.
+ */
+static skiplist_node_t *
+skiplist_node_create (skiplist_t * p_list, int top_level)
+{
+    size_t            num_levels = (size_t)top_level + 1;
+    skiplist_node_t * p_node
+        = calloc(1,
+                 sizeof(skiplist_node_t)
+                     + (num_levels * sizeof(skiplist_node_t *))
+                     + p_list->key_size);
+
+    if (NULL == p_node)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    if (0 != pthread_mutex_init(&p_node->node_lock, NULL))
+    {
+        fprintf(stderr, "Skip list node lock initialization failed.\n");
+        free(p_node);
+        p_node = NULL;
+        goto EXIT;
+    }
+
+    p_node->p_key     = &p_node->p_next[num_levels];
+    p_node->top_level = top_level;
+
+EXIT:
+    return p_node;
+}
+
+static void
+skiplist_node_destroy (skiplist_t * p_list, skiplist_node_t * p_node)
+{
+    if ((NULL != p_list->p_destroy_function) && (p_node != p_list->p_head))
+    {
+        p_list->p_destroy_function(p_node->p_value);
+    }
+
+    pthread_mutex_destroy(&p_node->node_lock);
+    free(p_node);
+}
+
+static inline skiplist_node_t *
+skiplist_next (skiplist_node_t * p_node, int level)
+{
+    return __atomic_load_n(&p_node->p_next[level], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Starts an operation that may stand on nodes: joins the reader
+ * counter of the current epoch and returns it for skiplist_leave(). The
+ * fence pairs with the one in skiplist_wait_readers(): either reclaim sees
+ * the operation counted, or the operation sees every node it retired already
+ * unlinked.
+ */
+static unsigned long *
+skiplist_enter (skiplist_t * p_list)
+{
+    unsigned long * p_readers
+        = &p_list->readers[__atomic_load_n(&p_list->reclaim_epoch,
+                                           __ATOMIC_ACQUIRE)
+                           & 1];
+
+    __atomic_fetch_add(p_readers, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return p_readers;
+}
+
+/**
+ * @brief Ends an operation started by skiplist_enter(), after its last access
+ * to a node.
+ */
+static void
+skiplist_leave (unsigned long * p_readers)
+{
+    __atomic_fetch_sub(p_readers, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Waits out a grace period. Each round starts a new epoch, so that new
+ * operations count themselves in the other counter, and yields until the
+ * counter of the previous epoch drops to zero. Two rounds are needed because
+ * an operation may load the epoch just before a flip and only then join the
+ * old counter; the second round waits for it. The caller holds reclaim_lock,
+ * which keeps grace periods from overlapping.
+ */
+static void
+skiplist_wait_readers (skiplist_t * p_list)
+{
+    for (int round = 0; round < 2; round++)
+    {
+        unsigned long epoch = __atomic_fetch_add(
+            &p_list->reclaim_epoch, 1, __ATOMIC_RELEASE);
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        while (0
+               != __atomic_load_n(&p_list->readers[epoch & 1],
+                                  __ATOMIC_ACQUIRE))
+        {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief Fills pp_preds and pp_succs with the last node before p_key and the
+ * node after it at every level. Returns the highest level at which p_key was
+ * found, or -1.
+ */
+static int
+skiplist_find_path (skiplist_t *       p_list,
+                    void *             p_key,
+                    skiplist_node_t ** pp_preds,
+                    skiplist_node_t ** pp_succs)
+{
+    int               found  = -1;
+    skiplist_node_t * p_pred = p_list->p_head;
+
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--)
+    {
+        skiplist_node_t * p_curr = skiplist_next(p_pred, level);
+        int               cmp_result = 1;
+
+        while ((NULL != p_curr)
+               && (0 > (cmp_result = p_list->p_compare(p_curr->p_key, p_key))))
+        {
+            p_pred = p_curr;
+            p_curr = skiplist_next(p_pred, level);
+        }
+
+        if ((-1 == found) && (NULL != p_curr) && (0 == cmp_result))
+        {
+            found = level;
+        }
+
+        pp_preds[level] = p_pred;
+        pp_succs[level] = p_curr;
+    }
+
+    return found;
+}
+
+/**
+ * @brief Unlocks the distinct predecessors locked at levels 0 to highest.
+ */
+static void
+skiplist_unlock_preds (skiplist_node_t ** pp_preds, int highest)
+{
+    skiplist_node_t * p_previous = NULL;
+
+    for (int level = 0; level <= highest; level++)
+    {
+        if (pp_preds[level] != p_previous)
+        {
+            pthread_mutex_unlock(&pp_preds[level]->node_lock);
+            p_previous = pp_preds[level];
+        }
+    }
+}
+
+/**
+ * @brief Locks the predecessors at levels 0 to top_level, bottom up, and
+ * checks that each is unremoved and still points at its expected successor.
+ * On return *p_highest is the highest level whose predecessor was visited,
+ * to be passed to skiplist_unlock_preds().
+ */
+static bool
+skiplist_lock_preds (skiplist_node_t ** pp_preds,
+                     skiplist_node_t ** pp_succs,
+                     int                top_level,
+                     bool               b_check_succ,
+                     int *              p_highest)
+{
+    bool              b_valid    = true;
+    skiplist_node_t * p_previous = NULL;
+
+    *p_highest = -1;
+
+    for (int level = 0; b_valid && (level <= top_level); level++)
+    {
+        skiplist_node_t * p_pred = pp_preds[level];
+        skiplist_node_t * p_succ = pp_succs[level];
+
+        if (p_pred != p_previous)
+        {
+            pthread_mutex_lock(&p_pred->node_lock);
+            p_previous = p_pred;
+        }
+
+        *p_highest = level;
+        b_valid    = !__atomic_load_n(&p_pred->b_marked, __ATOMIC_ACQUIRE)
+                  && (skiplist_next(p_pred, level) == p_succ)
+                  && (!b_check_succ || (NULL == p_succ)
+                      || !__atomic_load_n(&p_succ->b_marked,
+                                          __ATOMIC_ACQUIRE));
+    }
+
+    return b_valid;
+}
+
+skiplist_t *
+skiplist_create (size_t key_size,
+                 int (*p_compare)(void *, void *),
+                 void (*p_destroy)(void *))
+{
+    skiplist_t * p_list = NULL;
+
+    if ((0 == key_size) || (NULL == p_compare))
+    {
+        fprintf(stderr,
+                "Skip list needs a key size and comparison function.\n");
+        goto EXIT;
+    }
+
+    p_list = calloc(1, sizeof(skiplist_t));
+
+    if (NULL == p_list)
+    {
+        fprintf(stderr, GP_MEMORY_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    p_list->key_size           = key_size;
+    p_list->p_compare          = p_compare;
+    p_list->p_destroy_function = p_destroy;
+    p_list->p_retired          = NULL;
+    p_list->size               = 0;
+    p_list->p_head = skiplist_node_create(p_list, SKIPLIST_MAX_LEVEL - 1);
+
+    if (NULL == p_list->p_head)
+    {
+        free(p_list);
+        p_list = NULL;
+        goto EXIT;
+    }
+
+    if (0 != pthread_mutex_init(&p_list->reclaim_lock, NULL))
+    {
+        fprintf(stderr, "Lock initialization failure.\n");
+        skiplist_node_destroy(p_list, p_list->p_head);
+        free(p_list);
+        p_list = NULL;
+        goto EXIT;
+    }
+
+    p_list->p_head->b_fully_linked = true;
+
+EXIT:
+    return p_list;
+}
+
+void
+skiplist_destroy (skiplist_t * p_list)
+{
+    if (NULL == p_list)
+    {
+        goto EXIT;
+    }
+
+    skiplist_reclaim(p_list);
+
+    skiplist_node_t * p_node = p_list->p_head;
+
+    while (NULL != p_node)
+    {
+        skiplist_node_t * p_next = p_node->p_next[0];
+
+        skiplist_node_destroy(p_list, p_node);
+        p_node = p_next;
+    }
+
+    pthread_mutex_destroy(&p_list->reclaim_lock);
+    free(p_list);
+    p_list = NULL;
+
+EXIT:
+    return;
+}
+
+int
+skiplist_insert (skiplist_t * p_list, void * p_key, void * p_value)
+{
+    int               status = SUCCESS;
+    skiplist_node_t * pp_preds[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t * pp_succs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t * p_node    = NULL;
+    unsigned long *   p_readers = NULL;
+
+    if ((NULL == p_list) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_node = skiplist_node_create(p_list, skiplist_random_level());
+
+    if (NULL == p_node)
+    {
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_readers = skiplist_enter(p_list);
+
+    memcpy(p_node->p_key, p_key, p_list->key_size);
+    p_node->p_value = p_value;
+
+    for (;;)
+    {
+        int found = skiplist_find_path(p_list, p_key, pp_preds, pp_succs);
+
+        if (-1 != found)
+        {
+            skiplist_node_t * p_found = pp_succs[found];
+
+            if (__atomic_load_n(&p_found->b_marked, __ATOMIC_ACQUIRE))
+            {
+                // Being removed; once it is unlinked the key can go in
+                continue;
+            }
+
+            while (!__atomic_load_n(&p_found->b_fully_linked, __ATOMIC_ACQUIRE))
+            {
+                sched_yield();
+            }
+
+            fprintf(stderr,
+                    "Key already exists in skip list. Keys must be "
+                    "distinct.\n");
+
+            // The value still belongs to the caller
+            pthread_mutex_destroy(&p_node->node_lock);
+            free(p_node);
+            status = FAILURE;
+            goto EXIT;
+        }
+
+        int highest = -1;
+
+        if (!skiplist_lock_preds(
+                pp_preds, pp_succs, p_node->top_level, true, &highest))
+        {
+            skiplist_unlock_preds(pp_preds, highest);
+            continue;
+        }
+
+        for (int level = 0; level <= p_node->top_level; level++)
+        {
+            p_node->p_next[level] = pp_succs[level];
+        }
+
+        // Linked bottom up, so a reader that finds the node at some level
+        // can always descend through it
+        for (int level = 0; level <= p_node->top_level; level++)
+        {
+            __atomic_store_n(
+                &pp_preds[level]->p_next[level], p_node, __ATOMIC_RELEASE);
+        }
+
+        __atomic_store_n(&p_node->b_fully_linked, true, __ATOMIC_RELEASE);
+        skiplist_unlock_preds(pp_preds, highest);
+        break;
+    }
+
+    __atomic_add_fetch(&p_list->size, 1, __ATOMIC_RELAXED);
+
+EXIT:
+    if (NULL != p_readers)
+    {
+        skiplist_leave(p_readers);
+    }
+
+    return status;
+}
+
+int
+skiplist_find (skiplist_t * p_list, void * p_key, void ** pp_value)
+{
+    int               status    = FAILURE;
+    skiplist_node_t * p_pred    = NULL;
+    unsigned long *   p_readers = NULL;
+
+    if ((NULL == p_list) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        goto EXIT;
+    }
+
+    p_readers = skiplist_enter(p_list);
+    p_pred    = p_list->p_head;
+
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--)
+    {
+        skiplist_node_t * p_curr     = skiplist_next(p_pred, level);
+        int               cmp_result = 1;
+
+        while ((NULL != p_curr)
+               && (0 > (cmp_result = p_list->p_compare(p_curr->p_key, p_key))))
+        {
+            p_pred = p_curr;
+            p_curr = skiplist_next(p_pred, level);
+        }
+
+        if ((NULL != p_curr) && (0 == cmp_result))
+        {
+            if (__atomic_load_n(&p_curr->b_fully_linked, __ATOMIC_ACQUIRE)
+                && !__atomic_load_n(&p_curr->b_marked, __ATOMIC_ACQUIRE))
+            {
+                if (NULL != pp_value)
+                {
+                    *pp_value = p_curr->p_value;
+                }
+
+                status = SUCCESS;
+            }
+
+            break;
+        }
+    }
+
+    skiplist_leave(p_readers);
+
+EXIT:
+    return status;
+}
+
+int
+skiplist_remove (skiplist_t * p_list, void * p_key)
+{
+    int               status = SUCCESS;
+    skiplist_node_t * pp_preds[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t * pp_succs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t * p_victim  = NULL;
+    unsigned long *   p_readers = NULL;
+
+    if ((NULL == p_list) || (NULL == p_key))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_readers = skiplist_enter(p_list);
+
+    for (;;)
+    {
+        int found = skiplist_find_path(p_list, p_key, pp_preds, pp_succs);
+
+        if (NULL == p_victim)
+        {
+            skiplist_node_t * p_found = NULL;
+
+            if (-1 != found)
+            {
+                p_found = pp_succs[found];
+            }
+
+            // Only a node found at its own top level is fully linked and
+            // safe to take; anything else is half inserted or being removed
+            if ((NULL == p_found) || (p_found->top_level != found)
+                || !__atomic_load_n(&p_found->b_fully_linked, __ATOMIC_ACQUIRE)
+                || __atomic_load_n(&p_found->b_marked, __ATOMIC_ACQUIRE))
+            {
+                status = FAILURE;
+                goto EXIT;
+            }
+
+            pthread_mutex_lock(&p_found->node_lock);
+
+            if (__atomic_load_n(&p_found->b_marked, __ATOMIC_ACQUIRE))
+            {
+                pthread_mutex_unlock(&p_found->node_lock);
+                status = FAILURE;
+                goto EXIT;
+            }
+
+            // The mark is the linearization point: from here on the key is
+            // gone, and this thread alone finishes unlinking the node
+            __atomic_store_n(&p_found->b_marked, true, __ATOMIC_RELEASE);
+            p_victim = p_found;
+        }
+
+        int highest = -1;
+
+        for (int level = 0; level <= p_victim->top_level; level++)
+        {
+            pp_succs[level] = p_victim;
+        }
+
+        if (!skiplist_lock_preds(
+                pp_preds, pp_succs, p_victim->top_level, false, &highest))
+        {
+            skiplist_unlock_preds(pp_preds, highest);
+            continue;
+        }
+
+        for (int level = p_victim->top_level; level >= 0; level--)
+        {
+            __atomic_store_n(&pp_preds[level]->p_next[level],
+                             p_victim->p_next[level],
+                             __ATOMIC_RELEASE);
+        }
+
+        pthread_mutex_unlock(&p_victim->node_lock);
+        skiplist_unlock_preds(pp_preds, highest);
+        break;
+    }
+
+    // Other operations may still be on the node, so it is retired rather
+    // than freed; skiplist_reclaim() frees it once they have all finished
+    skiplist_node_t * p_top
+        = __atomic_load_n(&p_list->p_retired, __ATOMIC_RELAXED);
+
+    do
+    {
+        p_victim->p_retired_next = p_top;
+    } while (!__atomic_compare_exchange_n(&p_list->p_retired,
+                                          &p_top,
+                                          p_victim,
+                                          true,
+                                          __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+
+    __atomic_sub_fetch(&p_list->size, 1, __ATOMIC_RELAXED);
+
+EXIT:
+    if (NULL != p_readers)
+    {
+        skiplist_leave(p_readers);
+    }
+
+    return status;
+}
+
+int
+skiplist_range (skiplist_t * p_list,
+                void *       p_low,
+                void *       p_high,
+                bool (*p_visit)(void * p_key, void * p_value, void * p_context),
+                void * p_context)
+{
+    int               status    = SUCCESS;
+    skiplist_node_t * p_pred    = NULL;
+    unsigned long *   p_readers = NULL;
+
+    if ((NULL == p_list) || (NULL == p_visit))
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    p_readers = skiplist_enter(p_list);
+    p_pred    = p_list->p_head;
+
+    for (int level = SKIPLIST_MAX_LEVEL - 1; (NULL != p_low) && (level >= 0);
+         level--)
+    {
+        skiplist_node_t * p_curr = skiplist_next(p_pred, level);
+
+        while ((NULL != p_curr)
+               && (0 > p_list->p_compare(p_curr->p_key, p_low)))
+        {
+            p_pred = p_curr;
+            p_curr = skiplist_next(p_pred, level);
+        }
+    }
+
+    // Removed nodes keep their successors, so the walk can pass over them
+    for (skiplist_node_t * p_curr = skiplist_next(p_pred, 0); NULL != p_curr;
+         p_curr                   = skiplist_next(p_curr, 0))
+    {
+        if ((NULL != p_high) && (0 < p_list->p_compare(p_curr->p_key, p_high)))
+        {
+            break;
+        }
+
+        if (__atomic_load_n(&p_curr->b_fully_linked, __ATOMIC_ACQUIRE)
+            && !__atomic_load_n(&p_curr->b_marked, __ATOMIC_ACQUIRE)
+            && !p_visit(p_curr->p_key, p_curr->p_value, p_context))
+        {
+            break;
+        }
+    }
+
+    skiplist_leave(p_readers);
+
+EXIT:
+    return status;
+}
+
+int
+skiplist_reclaim (skiplist_t * p_list)
+{
+    int status = SUCCESS;
+
+    if (NULL == p_list)
+    {
+        fprintf(stderr, GP_POINTER_MESSAGE, __LINE__, __func__);
+        status = FAILURE;
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_list->reclaim_lock);
+
+    // Every node detached here was unlinked before it was retired, so only
+    // operations that began before the grace period can still reach it
+    skiplist_node_t * p_node
+        = __atomic_exchange_n(&p_list->p_retired, NULL, __ATOMIC_ACQUIRE);
+
+    if (NULL != p_node)
+    {
+        skiplist_wait_readers(p_list);
+    }
+
+    pthread_mutex_unlock(&p_list->reclaim_lock);
+
+    while (NULL != p_node)
+    {
+        skiplist_node_t * p_next = p_node->p_retired_next;
+
+        skiplist_node_destroy(p_list, p_node);
+        p_node = p_next;
+    }
+
+EXIT:
+    return status;
+}
+
+size_t
+skiplist_size (skiplist_t * p_list)
+{
+    size_t size = 0;
+
+    if (NULL != p_list)
+    {
+        size = __atomic_load_n(&p_list->size, __ATOMIC_RELAXED);
+    }
+
+    return size;
+}
+
+// End of skiplist.c
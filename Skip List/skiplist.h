@@ -0,0 +1,186 @@
+/**
+ * @file skiplist.h
+ * @brief Defines a concurrent ordered map built as a lazy skip list: lookups
+ * and range scans take no locks, and writers lock only the few nodes around
+ * the key they change.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#include "common.h"
+
+/**
+ * @brief Defines the number of levels of the head node, and so the tallest
+ * tower a node can have
+ *
+ */
+#define SKIPLIST_MAX_LEVEL 32
+
+/**
+ * @brief Defines the chance, as 1 in SKIPLIST_LEVEL_ODDS, that a tower grows
+ * by one more level. Four gives about 1.33 pointers per node.
+ *
+ */
+#define SKIPLIST_LEVEL_ODDS 4
+
+/**
+ * @brief A node of the skip list.
+ *
+ * A node is linked into levels 0 to top_level. Once b_fully_linked is set it
+ * is visible at every level; once b_marked is set it is logically removed.
+ * The key, key_size bytes, follows the tower of next pointers.
+ *
+ */
+typedef struct skiplist_node_t
+{
+    pthread_mutex_t node_lock; /**< Held while a writer relinks the node */
+    void *          p_key;     /**< Key, stored inside the node */
+    void *          p_value;   /**< Value stored for the key */
+    int             top_level; /**< Highest level the node is linked into */
+    bool            b_marked;  /**< Whether the node is logically removed */
+    bool b_fully_linked; /**< Whether the node is linked at every level */
+    struct skiplist_node_t * p_retired_next; /**< Next node awaiting
+                                                  reclamation */
+    struct skiplist_node_t * p_next[]; /**< Successor at each level */
+} skiplist_node_t;
+
+/**
+ * @brief Structure representing a concurrent skip list ordered map.
+ *
+ * Readers traverse without locking. Removed nodes are unlinked but not freed,
+ * since a reader may still be standing on them; they are kept on a retired
+ * list until skiplist_reclaim() or skiplist_destroy(). Every operation counts
+ * itself in readers for the epoch it started in, so that skiplist_reclaim()
+ * can wait for those that may still reach a retired node.
+ *
+ */
+typedef struct skiplist_t
+{
+    skiplist_node_t * p_head;    /**< Sentinel ordered before every key */
+    skiplist_node_t * p_retired; /**< Removed nodes not yet freed */
+    unsigned long reclaim_epoch; /**< Count of grace periods; its parity
+                                      selects the reader counter to join */
+    unsigned long readers[2]; /**< Operations in progress, by epoch parity */
+    pthread_mutex_t reclaim_lock; /**< Serializes grace periods */
+    size_t            key_size;  /**< Size in bytes of each key */
+    size_t            size;      /**< Number of keys in the list */
+    int (*p_compare)(void *, void *); /**< Pointer to the key ordering
+                                           function */
+    void (*p_destroy_function)(
+        void *); /**< Pointer to the function used to destroy values */
+} skiplist_t;
+
+/**
+ * @brief Create an empty skip list of keys of key_size bytes, copied into
+ * the list on insertion.
+ *
+ * @param key_size Size in bytes of one key.
+ * @param p_compare Ordering function for keys: negative, zero or positive as
+ * its first argument sorts before, with, or after its second.
+ * @param p_destroy Function used to destroy values once their node is freed,
+ * or NULL.
+ * @return A pointer to the newly created list, or NULL if creation fails.
+ * @warning Returns NULL in the event of memory allocation failure, lock
+ * initialization failure, a key_size of 0, or a NULL p_compare.
+ */
+skiplist_t * skiplist_create (size_t key_size,
+                              int (*p_compare)(void *, void *),
+                              void (*p_destroy)(void *));
+
+/**
+ * @brief Destroys every value, including those of removed keys, and frees
+ * the list. No other operation may be in progress.
+ *
+ * @param p_list A pointer to the skip list.
+ */
+void skiplist_destroy (skiplist_t * p_list);
+
+/**
+ * @brief Insert a copy of the key at p_key, mapped to p_value.
+ *
+ * @param p_list Pointer to the skip list.
+ * @param p_key Pointer to key_size bytes of key.
+ * @param p_value The value stored for the key.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs, memory
+ * allocation failure, or a key already in the list. Keys must be distinct.
+ */
+int skiplist_insert (skiplist_t * p_list, void * p_key, void * p_value);
+
+/**
+ * @brief Look up the value stored for a key, without locking.
+ *
+ * @param p_list Pointer to the skip list.
+ * @param p_key Pointer to the key to look up.
+ * @param pp_value Receives the value, may be NULL to test membership.
+ * @return SUCCESS if the key is present, FAILURE otherwise.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or a key not
+ * in the list.
+ */
+int skiplist_find (skiplist_t * p_list, void * p_key, void ** pp_value);
+
+/**
+ * @brief Remove a key. Its value is destroyed when the node is reclaimed.
+ *
+ * @param p_list Pointer to the skip list.
+ * @param p_key Pointer to the key to remove.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs or a key not
+ * in the list.
+ */
+int skiplist_remove (skiplist_t * p_list, void * p_key);
+
+/**
+ * @brief Call p_visit on every key from p_low to p_high inclusive, in
+ * ascending order, without locking. Keys inserted or removed during the scan
+ * may or may not be visited; every other key in range is visited once.
+ *
+ * @param p_list Pointer to the skip list.
+ * @param p_low Pointer to the lowest key to visit, or NULL to start at the
+ * smallest key.
+ * @param p_high Pointer to the highest key to visit, or NULL to end at the
+ * largest key.
+ * @param p_visit Function receiving each key, its value and p_context.
+ * Returning false stops the scan.
+ * @param p_context Argument passed to every call.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs.
+ */
+int skiplist_range (skiplist_t * p_list,
+                    void *       p_low,
+                    void *       p_high,
+                    bool (*p_visit)(void * p_key,
+                                    void * p_value,
+                                    void * p_context),
+                    void * p_context);
+
+/**
+ * @brief Free the nodes of removed keys and destroy their values.
+ *
+ * Waits for a grace period first: every operation that started before the
+ * call, and so may still be standing on a removed node, finishes before
+ * anything is freed. Other operations, including further reclaims, may run
+ * throughout.
+ *
+ * @param p_list Pointer to the skip list.
+ * @return SUCCESS on success, FAILURE on failure.
+ * @warning Returns FAILURE in the event of NULL pointer inputs. Must not be
+ * called from a skiplist_range() visit function, which would wait for its
+ * own scan.
+ */
+int skiplist_reclaim (skiplist_t * p_list);
+
+/**
+ * @brief Get the number of keys in the list.
+ *
+ * @param p_list Pointer to the skip list.
+ * @return The number of keys, or 0 if p_list is NULL.
+ */
+size_t skiplist_size (skiplist_t * p_list);
+
+#endif /* SKIPLIST_H */
+
+// End of skiplist.h
@@ -0,0 +1,680 @@
+#define _GNU_SOURCE
+#include "async_io.h"
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+/**
+ * @brief Pool task running a completed request's callback.
+ */
+static void
+async_io_dispatch (void * p_arg)
+{
+    async_io_request_t * p_request = (async_io_request_t *)p_arg;
+
+    if (NULL != p_request->p_callback)
+    {
+        p_request->p_callback(p_request->p_context, p_request->result);
+    }
+
+    free(p_request);
+}
+
+/**
+ * @brief Hands a completed request to the pool, or runs its callback on the
+ * calling thread if the pool's queue is full or it no longer accepts tasks.
+ *
+ * The completion threads never wait for room in the queue: every worker may
+ * be a submitter waiting for a free slot, and only these threads free slots.
+ * The caller has already released the request's slot for the same reason.
+ */
+static void
+async_io_complete (async_io_t * p_io, async_io_request_t * p_request)
+{
+    if (ASYNC_IO_NOP == p_request->opcode)
+    {
+        free(p_request);
+    }
+    else if (0
+             != threadpool_task_try_submit(
+                 p_io->p_pool, async_io_dispatch, p_request))
+    {
+        async_io_dispatch(p_request);
+    }
+}
+
+#ifdef __linux__
+
+static int
+async_io_uring_setup (async_io_t * p_io)
+{
+    int                    status = 0;
+    struct io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    // One entry more than the depth, for the wake-up request sent by destroy
+    p_io->ring_fd
+        = (int)syscall(__NR_io_uring_setup, p_io->depth + 1, &params);
+
+    if (0 > p_io->ring_fd)
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    p_io->sq_ring_size
+        = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+    p_io->cq_ring_size = params.cq_off.cqes
+                         + (params.cq_entries * sizeof(struct io_uring_cqe));
+    p_io->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (0 != (params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        if (p_io->cq_ring_size > p_io->sq_ring_size)
+        {
+            p_io->sq_ring_size = p_io->cq_ring_size;
+        }
+
+        p_io->cq_ring_size = 0;
+    }
+
+    p_io->p_sq_ring = mmap(NULL,
+                           p_io->sq_ring_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE,
+                           p_io->ring_fd,
+                           IORING_OFF_SQ_RING);
+    p_io->p_cq_ring = p_io->p_sq_ring;
+
+    if ((MAP_FAILED != p_io->p_sq_ring) && (0 != p_io->cq_ring_size))
+    {
+        p_io->p_cq_ring = mmap(NULL,
+                               p_io->cq_ring_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE,
+                               p_io->ring_fd,
+                               IORING_OFF_CQ_RING);
+    }
+
+    p_io->p_sqes = mmap(NULL,
+                        p_io->sqes_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        p_io->ring_fd,
+                        IORING_OFF_SQES);
+
+    if ((MAP_FAILED == p_io->p_sq_ring) || (MAP_FAILED == p_io->p_cq_ring)
+        || (MAP_FAILED == p_io->p_sqes))
+    {
+        fprintf(stderr, "io_uring ring mapping failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    uint8_t * p_sq = (uint8_t *)p_io->p_sq_ring;
+    uint8_t * p_cq = (uint8_t *)p_io->p_cq_ring;
+
+    p_io->p_sq_head  = (unsigned int *)(p_sq + params.sq_off.head);
+    p_io->p_sq_tail  = (unsigned int *)(p_sq + params.sq_off.tail);
+    p_io->p_sq_mask  = (unsigned int *)(p_sq + params.sq_off.ring_mask);
+    p_io->p_sq_array = (unsigned int *)(p_sq + params.sq_off.array);
+    p_io->p_cq_head  = (unsigned int *)(p_cq + params.cq_off.head);
+    p_io->p_cq_tail  = (unsigned int *)(p_cq + params.cq_off.tail);
+    p_io->p_cq_mask  = (unsigned int *)(p_cq + params.cq_off.ring_mask);
+    p_io->p_cqes     = p_cq + params.cq_off.cqes;
+
+    // One slot stays free for the wake-up request, even if the kernel gave
+    // fewer entries than asked for
+    if (p_io->depth >= params.sq_entries)
+    {
+        p_io->depth = params.sq_entries - 1;
+    }
+
+EXIT:
+    return status;
+}
+
+static void
+async_io_uring_teardown (async_io_t * p_io)
+{
+    if ((NULL != p_io->p_sqes) && (MAP_FAILED != p_io->p_sqes))
+    {
+        munmap(p_io->p_sqes, p_io->sqes_size);
+    }
+
+    if ((0 != p_io->cq_ring_size) && (NULL != p_io->p_cq_ring)
+        && (MAP_FAILED != p_io->p_cq_ring))
+    {
+        munmap(p_io->p_cq_ring, p_io->cq_ring_size);
+    }
+
+    if ((NULL != p_io->p_sq_ring) && (MAP_FAILED != p_io->p_sq_ring))
+    {
+        munmap(p_io->p_sq_ring, p_io->sq_ring_size);
+    }
+
+    if (0 <= p_io->ring_fd)
+    {
+        close(p_io->ring_fd);
+    }
+
+    p_io->p_sqes    = NULL;
+    p_io->p_cq_ring = NULL;
+    p_io->p_sq_ring = NULL;
+    p_io->ring_fd   = -1;
+}
+
+/**
+ * @brief Queues one request in the submission ring and tells the kernel. The
+ * context lock must be held, which makes this the only producer.
+ *
+ * On failure the entry is withdrawn from the ring, so the caller still owns
+ * the request and the kernel never sees its user_data.
+ */
+static int
+async_io_uring_submit (async_io_t * p_io, async_io_request_t * p_request)
+{
+    static const uint8_t  opcodes[]
+        = { IORING_OP_READV, IORING_OP_WRITEV, IORING_OP_NOP };
+    struct io_uring_sqe * p_sqes = (struct io_uring_sqe *)p_io->p_sqes;
+    int                   status = 0;
+    unsigned int          tail   = *p_io->p_sq_tail;
+    unsigned int          index  = tail & *p_io->p_sq_mask;
+    struct io_uring_sqe * p_sqe  = &p_sqes[index];
+
+    memset(p_sqe, 0, sizeof(*p_sqe));
+    p_sqe->opcode    = opcodes[p_request->opcode];
+    p_sqe->fd        = p_request->fd;
+    p_sqe->addr      = (uint64_t)(uintptr_t)&p_request->iov;
+    p_sqe->len       = 1;
+    p_sqe->off       = (uint64_t)p_request->offset;
+    p_sqe->user_data = (uint64_t)(uintptr_t)p_request;
+
+    p_io->p_sq_array[index] = index;
+    __atomic_store_n(p_io->p_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    for (;;)
+    {
+        long submitted
+            = syscall(__NR_io_uring_enter, p_io->ring_fd, 1, 0, 0, NULL, 0);
+
+        if (0 <= submitted)
+        {
+            break;
+        }
+
+        if ((EINTR != errno) && (EAGAIN != errno) && (EBUSY != errno))
+        {
+            // Without SQPOLL the kernel only consumes entries inside
+            // io_uring_enter; if it did not take this one, take it back
+            if (tail == __atomic_load_n(p_io->p_sq_head, __ATOMIC_ACQUIRE))
+            {
+                __atomic_store_n(p_io->p_sq_tail, tail, __ATOMIC_RELEASE);
+                fprintf(stderr, "io_uring submission failure.\n");
+                status = -1;
+            }
+
+            break;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Completion thread of the io_uring backend: moves completions to the
+ * pool until destroy's wake-up request arrives and nothing is in flight.
+ */
+static void *
+async_io_uring_reaper (void * p_arg)
+{
+    async_io_t * p_io       = (async_io_t *)p_arg;
+    bool         b_stopping = false;
+
+    for (;;)
+    {
+        unsigned int head  = *p_io->p_cq_head;
+        unsigned int tail  = __atomic_load_n(p_io->p_cq_tail, __ATOMIC_ACQUIRE);
+        unsigned int count = 0;
+
+        async_io_request_t * p_completed = NULL;
+
+        if (head == tail)
+        {
+            syscall(__NR_io_uring_enter,
+                    p_io->ring_fd,
+                    0,
+                    1,
+                    IORING_ENTER_GETEVENTS,
+                    NULL,
+                    0);
+            continue;
+        }
+
+        for (; head != tail; head++)
+        {
+            struct io_uring_cqe * p_cqe = &(
+                (struct io_uring_cqe *)p_io->p_cqes)[head & *p_io->p_cq_mask];
+            async_io_request_t * p_request
+                = (async_io_request_t *)(uintptr_t)p_cqe->user_data;
+
+            p_request->result = p_cqe->res;
+            p_request->p_next = p_completed;
+            p_completed       = p_request;
+            b_stopping |= (ASYNC_IO_NOP == p_request->opcode);
+            count++;
+        }
+
+        __atomic_store_n(p_io->p_cq_head, head, __ATOMIC_RELEASE);
+
+        // The slots are released before the callbacks are handed over; see
+        // async_io_complete()
+        pthread_mutex_lock(&p_io->lock);
+        p_io->in_flight -= count;
+        pthread_cond_broadcast(&p_io->not_full);
+        bool b_done = b_stopping && (0 == p_io->in_flight);
+        pthread_mutex_unlock(&p_io->lock);
+
+        while (NULL != p_completed)
+        {
+            async_io_request_t * p_request = p_completed;
+
+            p_completed = p_request->p_next;
+            async_io_complete(p_io, p_request);
+        }
+
+        if (b_done)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+#else
+
+static int
+async_io_uring_setup (async_io_t * p_io)
+{
+    (void)p_io;
+    return -1;
+}
+
+static void
+async_io_uring_teardown (async_io_t * p_io)
+{
+    (void)p_io;
+}
+
+static int
+async_io_uring_submit (async_io_t * p_io, async_io_request_t * p_request)
+{
+    (void)p_io;
+    (void)p_request;
+    return -1;
+}
+
+static void *
+async_io_uring_reaper (void * p_arg)
+{
+    return p_arg;
+}
+
+#endif /* __linux__ */
+
+/**
+ * @brief I/O thread of the fallback backend.
+ */
+static void *
+async_io_thread (void * p_arg)
+{
+    async_io_t * p_io = (async_io_t *)p_arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&p_io->lock);
+
+        while ((NULL == p_io->p_head) && !p_io->b_stopping)
+        {
+            pthread_cond_wait(&p_io->not_empty, &p_io->lock);
+        }
+
+        async_io_request_t * p_request = p_io->p_head;
+
+        if (NULL == p_request)
+        {
+            pthread_mutex_unlock(&p_io->lock);
+            break;
+        }
+
+        p_io->p_head = p_request->p_next;
+
+        if (NULL == p_io->p_head)
+        {
+            p_io->p_tail = NULL;
+        }
+
+        pthread_mutex_unlock(&p_io->lock);
+
+        ssize_t result = 0;
+
+        if (ASYNC_IO_READ == p_request->opcode)
+        {
+            result = pread(p_request->fd,
+                           p_request->iov.iov_base,
+                           p_request->iov.iov_len,
+                           p_request->offset);
+        }
+        else
+        {
+            result = pwrite(p_request->fd,
+                            p_request->iov.iov_base,
+                            p_request->iov.iov_len,
+                            p_request->offset);
+        }
+
+        p_request->result = (0 > result) ? -errno : result;
+
+        pthread_mutex_lock(&p_io->lock);
+        p_io->in_flight--;
+        pthread_cond_signal(&p_io->not_full);
+        pthread_mutex_unlock(&p_io->lock);
+
+        async_io_complete(p_io, p_request);
+    }
+
+    return NULL;
+}
+
+async_io_t *
+async_io_create (threadpool_t * p_pool,
+                 unsigned int   depth,
+                 bool           b_force_threads)
+{
+    async_io_t * p_io = NULL;
+
+    if (NULL == p_pool)
+    {
+        goto EXIT;
+    }
+
+    p_io = calloc(1, sizeof(async_io_t));
+
+    if (NULL == p_io)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    p_io->p_pool     = p_pool;
+    p_io->depth      = (0 == depth) ? ASYNC_IO_DEFAULT_DEPTH : depth;
+    p_io->in_flight  = 0;
+    p_io->b_stopping = false;
+    p_io->ring_fd    = -1;
+    p_io->backend    = ASYNC_IO_THREADS;
+
+    if (!b_force_threads)
+    {
+        if (0 == async_io_uring_setup(p_io))
+        {
+            p_io->backend = ASYNC_IO_URING;
+        }
+        else
+        {
+            async_io_uring_teardown(p_io);
+        }
+    }
+
+    p_io->num_threads
+        = (ASYNC_IO_URING == p_io->backend) ? 1 : ASYNC_IO_FALLBACK_THREADS;
+    p_io->p_threads = calloc(p_io->num_threads, sizeof(pthread_t));
+
+    if (NULL == p_io->p_threads)
+    {
+        async_io_uring_teardown(p_io);
+        free(p_io);
+        p_io = NULL;
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    pthread_mutex_init(&p_io->lock, NULL);
+    pthread_cond_init(&p_io->not_full, NULL);
+    pthread_cond_init(&p_io->not_empty, NULL);
+
+    for (int index = 0; index < p_io->num_threads; index++)
+    {
+        void * (*p_thread_function)(void *)
+            = (ASYNC_IO_URING == p_io->backend) ? async_io_uring_reaper
+                                                : async_io_thread;
+
+        if (0
+            != pthread_create(
+                &p_io->p_threads[index], NULL, p_thread_function, p_io))
+        {
+            fprintf(stderr, "Thread create failure.\n");
+
+            // Only the fallback backend can have started threads here
+            pthread_mutex_lock(&p_io->lock);
+            p_io->b_stopping = true;
+            pthread_cond_broadcast(&p_io->not_empty);
+            pthread_mutex_unlock(&p_io->lock);
+
+            for (int thread = 0; thread < index; thread++)
+            {
+                pthread_join(p_io->p_threads[thread], NULL);
+            }
+
+            pthread_mutex_destroy(&p_io->lock);
+            pthread_cond_destroy(&p_io->not_full);
+            pthread_cond_destroy(&p_io->not_empty);
+            async_io_uring_teardown(p_io);
+            free(p_io->p_threads);
+            free(p_io);
+            p_io = NULL;
+            goto EXIT;
+        }
+    }
+
+EXIT:
+    return p_io;
+}
+
+/**
+ * @brief Waits for a free slot and hands a request to the backend. The
+ * wake-up request of destroy bypasses the stopping check and the slot limit,
+ * which reserves a ring entry for it.
+ */
+static int
+async_io_submit (async_io_t * p_io, async_io_request_t * p_request)
+{
+    int  status  = 0;
+    bool b_wakeup = (ASYNC_IO_NOP == p_request->opcode);
+
+    pthread_mutex_lock(&p_io->lock);
+
+    while (!b_wakeup && !p_io->b_stopping && (p_io->in_flight >= p_io->depth))
+    {
+        pthread_cond_wait(&p_io->not_full, &p_io->lock);
+    }
+
+    if (!b_wakeup && p_io->b_stopping)
+    {
+        status = -1;
+        goto EXIT_UNLOCK;
+    }
+
+    if (ASYNC_IO_URING == p_io->backend)
+    {
+        status = async_io_uring_submit(p_io, p_request);
+    }
+    else
+    {
+        p_request->p_next = NULL;
+
+        if (NULL == p_io->p_tail)
+        {
+            p_io->p_head = p_request;
+        }
+        else
+        {
+            p_io->p_tail->p_next = p_request;
+        }
+
+        p_io->p_tail = p_request;
+        pthread_cond_signal(&p_io->not_empty);
+    }
+
+    if (0 == status)
+    {
+        p_io->in_flight++;
+    }
+
+EXIT_UNLOCK:
+    pthread_mutex_unlock(&p_io->lock);
+
+    return status;
+}
+
+static int
+async_io_start (async_io_t *        p_io,
+                async_io_opcode_t   opcode,
+                int                 fd,
+                void *              p_buffer,
+                size_t              length,
+                off_t               offset,
+                async_io_callback_t p_callback,
+                void *              p_context)
+{
+    int                  status    = 0;
+    async_io_request_t * p_request = NULL;
+
+    if ((NULL == p_io) || (NULL == p_buffer))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    p_request = calloc(1, sizeof(async_io_request_t));
+
+    if (NULL == p_request)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    p_request->opcode       = opcode;
+    p_request->fd           = fd;
+    p_request->iov.iov_base = p_buffer;
+    p_request->iov.iov_len  = length;
+    p_request->offset       = offset;
+    p_request->p_callback   = p_callback;
+    p_request->p_context    = p_context;
+
+    status = async_io_submit(p_io, p_request);
+
+    if (0 != status)
+    {
+        free(p_request);
+    }
+
+EXIT:
+    return status;
+}
+
+int
+async_io_read (async_io_t *        p_io,
+               int                 fd,
+               void *              p_buffer,
+               size_t              length,
+               off_t               offset,
+               async_io_callback_t p_callback,
+               void *              p_context)
+{
+    return async_io_start(p_io,
+                          ASYNC_IO_READ,
+                          fd,
+                          p_buffer,
+                          length,
+                          offset,
+                          p_callback,
+                          p_context);
+}
+
+int
+async_io_write (async_io_t *        p_io,
+                int                 fd,
+                const void *        p_buffer,
+                size_t              length,
+                off_t               offset,
+                async_io_callback_t p_callback,
+                void *              p_context)
+{
+    return async_io_start(p_io,
+                          ASYNC_IO_WRITE,
+                          fd,
+                          (void *)p_buffer,
+                          length,
+                          offset,
+                          p_callback,
+                          p_context);
+}
+
+void
+async_io_destroy (async_io_t * p_io)
+{
+    if (NULL == p_io)
+    {
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_io->lock);
+    p_io->b_stopping = true;
+    pthread_cond_broadcast(&p_io->not_empty);
+    pthread_cond_broadcast(&p_io->not_full);
+    pthread_mutex_unlock(&p_io->lock);
+
+    // The completion thread sleeps in the kernel; a no-op request wakes it
+    // once everything submitted before it has completed
+    if (ASYNC_IO_URING == p_io->backend)
+    {
+        async_io_request_t * p_wakeup = calloc(1, sizeof(async_io_request_t));
+
+        if (NULL != p_wakeup)
+        {
+            p_wakeup->opcode = ASYNC_IO_NOP;
+        }
+
+        if ((NULL == p_wakeup) || (0 != async_io_submit(p_io, p_wakeup)))
+        {
+            fprintf(stderr, "Cannot stop io_uring completion thread.\n");
+            free(p_wakeup);
+            goto EXIT;
+        }
+    }
+
+    for (int index = 0; index < p_io->num_threads; index++)
+    {
+        pthread_join(p_io->p_threads[index], NULL);
+    }
+
+    async_io_uring_teardown(p_io);
+    pthread_mutex_destroy(&p_io->lock);
+    pthread_cond_destroy(&p_io->not_full);
+    pthread_cond_destroy(&p_io->not_empty);
+
+    free(p_io->p_threads);
+    free(p_io);
+    p_io = NULL;
+
+EXIT:
+    return;
+}
+
+// End of async_io.c
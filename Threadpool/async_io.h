@@ -0,0 +1,186 @@
+/**
+ * @file async_io.h
+ * @brief Defines asynchronous file I/O whose completions run as thread pool
+ * tasks.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include "threadpool.h"
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Defines the queue depth used when async_io_create() is given 0
+ *
+ */
+#define ASYNC_IO_DEFAULT_DEPTH 64
+
+/**
+ * @brief Defines the number of blocking I/O threads of the fallback backend
+ *
+ */
+#define ASYNC_IO_FALLBACK_THREADS 4
+
+/**
+ * @brief Callback run on the pool when a request completes, or on the
+ * completion thread when the pool's queue is full.
+ *
+ * @param p_context The context given with the request.
+ * @param result Bytes transferred, or a negative errno value.
+ */
+typedef void (*async_io_callback_t)(void * p_context, ssize_t result);
+
+/**
+ * @brief Backends able to carry out requests.
+ */
+typedef enum async_io_backend_t
+{
+    ASYNC_IO_URING   = 0, /**< Linux io_uring, one completion thread. */
+    ASYNC_IO_THREADS = 1, /**< Blocking pread/pwrite on helper threads. */
+} async_io_backend_t;
+
+/**
+ * @brief Operations a request can perform.
+ */
+typedef enum async_io_opcode_t
+{
+    ASYNC_IO_READ  = 0, /**< Read into the buffer. */
+    ASYNC_IO_WRITE = 1, /**< Write from the buffer. */
+    ASYNC_IO_NOP   = 2, /**< No operation, used to wake the backend. */
+} async_io_opcode_t;
+
+struct async_io_t;
+
+/**
+ * @brief A request in flight.
+ */
+typedef struct async_io_request_t
+{
+    async_io_opcode_t   opcode;     /**< Operation to perform. */
+    int                 fd;         /**< File descriptor. */
+    struct iovec        iov;        /**< Buffer and length. */
+    off_t               offset;     /**< File offset. */
+    async_io_callback_t p_callback; /**< Completion callback, may be NULL. */
+    void *              p_context;  /**< Argument for the callback. */
+    ssize_t             result;     /**< Result passed to the callback. */
+    struct async_io_request_t * p_next; /**< Next request in the fallback
+                                             queue. */
+} async_io_request_t;
+
+/**
+ * @brief An asynchronous I/O context bound to a thread pool.
+ */
+typedef struct async_io_t
+{
+    threadpool_t *     p_pool;  /**< Pool the callbacks run on. */
+    async_io_backend_t backend; /**< Backend in use. */
+    unsigned int       depth;   /**< Maximum number of requests in flight. */
+    unsigned int       in_flight; /**< Requests submitted, not completed. */
+    bool               b_stopping; /**< Whether destroy has begun. */
+    pthread_mutex_t lock; /**< Mutex for thread-safe access to the context. */
+    pthread_cond_t
+        not_full; /**< Condition variable for signaling free slots. */
+    pthread_cond_t
+        not_empty; /**< Condition variable for signaling queued requests
+                      (fallback backend). */
+    async_io_request_t * p_head; /**< First queued request (fallback). */
+    async_io_request_t * p_tail; /**< Last queued request (fallback). */
+    pthread_t * p_threads;   /**< Completion or fallback I/O threads. */
+    int         num_threads; /**< Number of entries in p_threads. */
+    int         ring_fd;     /**< io_uring file descriptor, or -1. */
+    void *      p_sq_ring;   /**< Submission ring mapping. */
+    size_t      sq_ring_size; /**< Size of the submission ring mapping. */
+    void *      p_cq_ring;    /**< Completion ring mapping. */
+    size_t      cq_ring_size; /**< Size of the completion ring mapping. */
+    void *      p_sqes;       /**< Submission queue entries mapping. */
+    size_t      sqes_size;    /**< Size of the submission entries mapping. */
+    unsigned int * p_sq_head;  /**< Kernel submission ring head. */
+    unsigned int * p_sq_tail;  /**< Kernel submission ring tail. */
+    unsigned int * p_sq_mask;  /**< Kernel submission ring mask. */
+    unsigned int * p_sq_array; /**< Kernel submission index array. */
+    unsigned int * p_cq_head;  /**< Kernel completion ring head. */
+    unsigned int * p_cq_tail;  /**< Kernel completion ring tail. */
+    unsigned int * p_cq_mask;  /**< Kernel completion ring mask. */
+    void *         p_cqes;     /**< Kernel completion entries. */
+} async_io_t;
+
+/**
+ * @brief Creates an asynchronous I/O context for a pool.
+ *
+ * io_uring is used when the kernel allows it; otherwise, or when
+ * b_force_threads is set, ASYNC_IO_FALLBACK_THREADS helper threads perform
+ * blocking pread/pwrite calls so pool workers still never wait on the disk.
+ *
+ * @param p_pool The pool completion callbacks run on.
+ * @param depth Maximum requests in flight, or 0 for ASYNC_IO_DEFAULT_DEPTH.
+ * Submitters block while the limit is reached.
+ * @param b_force_threads Use the thread backend even if io_uring works.
+ * @return A pointer to the new context, or NULL.
+ * @warning Returns NULL if p_pool is NULL or in the event of memory
+ * allocation or thread creation failure.
+ */
+async_io_t * async_io_create (threadpool_t * p_pool,
+                              unsigned int   depth,
+                              bool           b_force_threads);
+
+/**
+ * @brief Waits for every request in flight to complete, hands the remaining
+ * callbacks to the pool, and frees the context.
+ *
+ * Callbacks may still be running when this returns; use
+ * threadpool_wait_idle() to wait for them.
+ *
+ * @param p_io A pointer to the context.
+ */
+void async_io_destroy (async_io_t * p_io);
+
+/**
+ * @brief Starts reading length bytes at offset from fd into p_buffer.
+ *
+ * @param p_io A pointer to the context.
+ * @param fd File descriptor to read from.
+ * @param p_buffer Destination, valid until the callback runs.
+ * @param length Number of bytes to read.
+ * @param offset File offset to read at.
+ * @param p_callback Callback run on the pool with the result, may be NULL.
+ * @param p_context Argument for the callback.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if p_io or p_buffer is NULL, the context is being
+ * destroyed, or in the event of memory allocation or submission failure.
+ */
+int async_io_read (async_io_t *        p_io,
+                   int                 fd,
+                   void *              p_buffer,
+                   size_t              length,
+                   off_t               offset,
+                   async_io_callback_t p_callback,
+                   void *              p_context);
+
+/**
+ * @brief Starts writing length bytes from p_buffer to fd at offset.
+ *
+ * @param p_io A pointer to the context.
+ * @param fd File descriptor to write to.
+ * @param p_buffer Source, valid until the callback runs.
+ * @param length Number of bytes to write.
+ * @param offset File offset to write at.
+ * @param p_callback Callback run on the pool with the result, may be NULL.
+ * @param p_context Argument for the callback.
+ * @return 0 on success, -1 on failure.
+ * @warning Same failure cases as async_io_read().
+ */
+int async_io_write (async_io_t *        p_io,
+                    int                 fd,
+                    const void *        p_buffer,
+                    size_t              length,
+                    off_t               offset,
+                    async_io_callback_t p_callback,
+                    void *              p_context);
+
+#endif /* ASYNC_IO_H */
+
+// End of async_io.h
@@ -0,0 +1,390 @@
+#define _GNU_SOURCE
+#include "coroutine.h"
+#include <sys/mman.h>
+
+/**
+ * @brief Coroutine running on the calling thread, or NULL.
+ */
+static _Thread_local coroutine_t * gp_current_coroutine = NULL;
+
+/**
+ * @brief Coroutines a worker resumes itself because their pool's queues were
+ * full, and whether a frame on the worker is already resuming them.
+ */
+typedef struct coroutine_overflow_t
+{
+    coroutine_t * p_head;     /**< Coroutines waiting to be resumed. */
+    bool          b_draining; /**< Whether the list is being resumed. */
+} coroutine_overflow_t;
+
+static _Thread_local coroutine_overflow_t g_coroutine_overflow = { 0 };
+
+static void coroutine_resume (void * p_arg);
+static void coroutine_free (coroutine_t * p_coroutine);
+
+/**
+ * @brief Reads the thread-local through a call the compiler cannot inline, so
+ * a coroutine that moved to another worker never reuses a cached TLS address.
+ */
+__attribute__((noinline)) coroutine_t *
+coroutine_current (void)
+{
+    return gp_current_coroutine;
+}
+
+__attribute__((noinline)) static void
+coroutine_set_current (coroutine_t * p_coroutine)
+{
+    gp_current_coroutine = p_coroutine;
+}
+
+__attribute__((noinline)) static coroutine_overflow_t *
+coroutine_overflow (void)
+{
+    return &g_coroutine_overflow;
+}
+
+void
+awaitable_init (awaitable_t * p_awaitable)
+{
+    if (NULL != p_awaitable)
+    {
+        atomic_init(&p_awaitable->state, AWAITABLE_PENDING);
+        p_awaitable->p_waiter   = NULL;
+        p_awaitable->p_result   = NULL;
+        p_awaitable->b_signaled = false;
+
+        pthread_mutex_init(&p_awaitable->lock, NULL);
+        pthread_cond_init(&p_awaitable->cond, NULL);
+    }
+}
+
+void
+awaitable_destroy (awaitable_t * p_awaitable)
+{
+    if (NULL != p_awaitable)
+    {
+        pthread_mutex_destroy(&p_awaitable->lock);
+        pthread_cond_destroy(&p_awaitable->cond);
+    }
+}
+
+/**
+ * @brief Resumes a coroutine on the calling worker. Coroutines scheduled
+ * while one is being resumed here are queued behind it rather than resumed
+ * recursively, so a coroutine that keeps yielding cannot exhaust the stack.
+ */
+static void
+coroutine_run_inline (coroutine_t * p_coroutine)
+{
+    coroutine_overflow_t * p_overflow = coroutine_overflow();
+
+    p_coroutine->p_next = p_overflow->p_head;
+    p_overflow->p_head  = p_coroutine;
+
+    if (p_overflow->b_draining)
+    {
+        goto EXIT;
+    }
+
+    // Any coroutine resumed below returns here on this thread when it
+    // suspends, so p_overflow stays the calling worker's list
+    p_overflow->b_draining = true;
+
+    while (NULL != p_overflow->p_head)
+    {
+        coroutine_t * p_next = p_overflow->p_head;
+
+        p_overflow->p_head = p_next->p_next;
+        coroutine_resume(p_next);
+    }
+
+    p_overflow->b_draining = false;
+
+EXIT:
+    return;
+}
+
+/**
+ * @brief Puts a suspended coroutine back on its pool. The coroutine is held
+ * by the pool, so this succeeds while the pool drains; if the pool has been
+ * stopped the coroutine can never resume and is freed instead.
+ */
+static void
+coroutine_schedule (coroutine_t * p_coroutine)
+{
+    threadpool_t * p_pool = p_coroutine->p_pool;
+    int            status = -1;
+
+    if (threadpool_in_worker(p_pool))
+    {
+        // A worker must not block on a queue it may be the only consumer
+        // of; if the queue is full it runs the coroutine itself
+        status = threadpool_submit_held(
+            p_pool, coroutine_resume, p_coroutine, false);
+
+        if ((0 != status)
+            && (THREADPOOL_STOPPED != atomic_load(&p_pool->state)))
+        {
+            coroutine_run_inline(p_coroutine);
+            status = 0;
+        }
+    }
+    else
+    {
+        status = threadpool_submit_held(
+            p_pool, coroutine_resume, p_coroutine, true);
+    }
+
+    if (0 != status)
+    {
+        fprintf(stderr, "Pool stopped; discarding a suspended coroutine.\n");
+        coroutine_free(p_coroutine);
+    }
+}
+
+void
+awaitable_complete (awaitable_t * p_awaitable, void * p_result)
+{
+    if (NULL == p_awaitable)
+    {
+        goto EXIT;
+    }
+
+    p_awaitable->p_result = p_result;
+
+    int previous = atomic_exchange(&p_awaitable->state, AWAITABLE_DONE);
+
+    if (AWAITABLE_WAITING == previous)
+    {
+        coroutine_schedule(p_awaitable->p_waiter);
+    }
+    else if (AWAITABLE_WAITING_THREAD == previous)
+    {
+        // The waiter may destroy the awaitable as soon as it sees b_signaled,
+        // so nothing is touched after the unlock
+        pthread_mutex_lock(&p_awaitable->lock);
+        p_awaitable->b_signaled = true;
+        pthread_cond_signal(&p_awaitable->cond);
+        pthread_mutex_unlock(&p_awaitable->lock);
+    }
+
+EXIT:
+    return;
+}
+
+static void
+coroutine_entry (void)
+{
+    coroutine_t * p_coroutine = coroutine_current();
+
+    p_coroutine->p_function(p_coroutine->p_argument);
+    p_coroutine->b_finished = true;
+
+    // The resuming worker changes between runs, so uc_link cannot be used
+    swapcontext(&p_coroutine->context, &p_coroutine->caller);
+}
+
+/**
+ * @brief Frees a coroutine that is not running and ends the pool's hold on
+ * it.
+ */
+static void
+coroutine_free (coroutine_t * p_coroutine)
+{
+    threadpool_t * p_pool = p_coroutine->p_pool;
+
+    munmap(p_coroutine->p_stack, p_coroutine->stack_size);
+    free(p_coroutine);
+    threadpool_release(p_pool);
+}
+
+static void
+coroutine_resume (void * p_arg)
+{
+    coroutine_t * p_coroutine = (coroutine_t *)p_arg;
+    coroutine_t * p_previous  = coroutine_current();
+
+    coroutine_set_current(p_coroutine);
+    swapcontext(&p_coroutine->caller, &p_coroutine->context);
+    coroutine_set_current(p_previous);
+
+    if (p_coroutine->b_finished)
+    {
+        coroutine_free(p_coroutine);
+    }
+    else if (p_coroutine->b_yielded)
+    {
+        p_coroutine->b_yielded = false;
+        coroutine_schedule(p_coroutine);
+    }
+    else if (NULL != p_coroutine->p_awaiting)
+    {
+        awaitable_t * p_awaitable = p_coroutine->p_awaiting;
+        int           expected    = AWAITABLE_PENDING;
+
+        // Publish the waiter only now that its stack is no longer in use; if
+        // the awaitable completed meanwhile, resume straight away
+        p_coroutine->p_awaiting = NULL;
+        p_awaitable->p_waiter   = p_coroutine;
+
+        if (!atomic_compare_exchange_strong(
+                &p_awaitable->state, &expected, AWAITABLE_WAITING))
+        {
+            coroutine_schedule(p_coroutine);
+        }
+    }
+}
+
+int
+coroutine_spawn (threadpool_t * p_pool,
+                 void (*p_function)(void *),
+                 void * p_argument,
+                 size_t stack_size)
+{
+    int           status      = 0;
+    coroutine_t * p_coroutine = NULL;
+    size_t        page_size   = (size_t)sysconf(_SC_PAGESIZE);
+
+    if ((NULL == p_pool) || (NULL == p_function))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    if (0 == stack_size)
+    {
+        stack_size = COROUTINE_DEFAULT_STACK_SIZE;
+    }
+
+    // Round up to whole pages and add the guard page
+    stack_size = ((stack_size + page_size - 1) / page_size) * page_size;
+    stack_size += page_size;
+
+    p_coroutine = calloc(1, sizeof(coroutine_t));
+
+    if (NULL == p_coroutine)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    p_coroutine->p_stack = mmap(NULL,
+                                stack_size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+                                -1,
+                                0);
+
+    if (MAP_FAILED == p_coroutine->p_stack)
+    {
+        fprintf(stderr, "Coroutine stack allocation failure.\n");
+        free(p_coroutine);
+        status = -1;
+        goto EXIT;
+    }
+
+    mprotect(p_coroutine->p_stack, page_size, PROT_NONE);
+
+    // The pool counts the coroutine as outstanding until it finishes, even
+    // while it is suspended and in no queue
+    if (0 != threadpool_hold(p_pool))
+    {
+        munmap(p_coroutine->p_stack, stack_size);
+        free(p_coroutine);
+        status = -1;
+        goto EXIT;
+    }
+
+    p_coroutine->stack_size = stack_size;
+    p_coroutine->p_pool     = p_pool;
+    p_coroutine->p_function = p_function;
+    p_coroutine->p_argument = p_argument;
+
+    getcontext(&p_coroutine->context);
+    p_coroutine->context.uc_stack.ss_sp   = p_coroutine->p_stack;
+    p_coroutine->context.uc_stack.ss_size = stack_size;
+    p_coroutine->context.uc_link          = NULL;
+    makecontext(&p_coroutine->context, coroutine_entry, 0);
+
+    status = threadpool_submit_held(
+        p_pool, coroutine_resume, p_coroutine, true);
+
+    if (0 != status)
+    {
+        coroutine_free(p_coroutine);
+    }
+
+EXIT:
+    return status;
+}
+
+void *
+coroutine_await (awaitable_t * p_awaitable)
+{
+    void * p_result = NULL;
+
+    if (NULL == p_awaitable)
+    {
+        goto EXIT;
+    }
+
+    if (AWAITABLE_DONE == atomic_load(&p_awaitable->state))
+    {
+        p_result = p_awaitable->p_result;
+        goto EXIT;
+    }
+
+    coroutine_t * p_coroutine = coroutine_current();
+
+    if (NULL != p_coroutine)
+    {
+        // The worker registers us as the waiter after the switch
+        p_coroutine->p_awaiting = p_awaitable;
+        swapcontext(&p_coroutine->context, &p_coroutine->caller);
+    }
+    else
+    {
+        int expected = AWAITABLE_PENDING;
+
+        pthread_mutex_lock(&p_awaitable->lock);
+
+        if (atomic_compare_exchange_strong(
+                &p_awaitable->state, &expected, AWAITABLE_WAITING_THREAD))
+        {
+            while (!p_awaitable->b_signaled)
+            {
+                pthread_cond_wait(&p_awaitable->cond, &p_awaitable->lock);
+            }
+        }
+
+        pthread_mutex_unlock(&p_awaitable->lock);
+    }
+
+    p_result = p_awaitable->p_result;
+
+EXIT:
+    return p_result;
+}
+
+int
+coroutine_yield (void)
+{
+    int           status      = 0;
+    coroutine_t * p_coroutine = coroutine_current();
+
+    if (NULL == p_coroutine)
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    p_coroutine->b_yielded = true;
+    swapcontext(&p_coroutine->context, &p_coroutine->caller);
+
+EXIT:
+    return status;
+}
+
+// End of coroutine.c
@@ -0,0 +1,149 @@
+/**
+ * @file coroutine.h
+ * @brief Defines resumable tasks that suspend on awaitables instead of
+ * blocking thread pool workers.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "threadpool.h"
+#include <ucontext.h>
+
+/**
+ * @brief Defines the stack size used when coroutine_spawn() is given 0
+ *
+ */
+#define COROUTINE_DEFAULT_STACK_SIZE (64 * 1024)
+
+/**
+ * @brief States of an awaitable.
+ */
+typedef enum awaitable_state_t
+{
+    AWAITABLE_PENDING        = 0, /**< Not completed, nobody waiting. */
+    AWAITABLE_WAITING        = 1, /**< A suspended coroutine is waiting. */
+    AWAITABLE_WAITING_THREAD = 2, /**< A blocked thread is waiting. */
+    AWAITABLE_DONE           = 3, /**< Completed. */
+} awaitable_state_t;
+
+struct coroutine_t;
+
+/**
+ * @brief A one-shot event a single coroutine or thread can wait on.
+ */
+typedef struct awaitable_t
+{
+    atomic_int           state;    /**< Current awaitable_state_t. */
+    struct coroutine_t * p_waiter; /**< Coroutine to resume on completion. */
+    void *               p_result; /**< Value passed to awaitable_complete. */
+    pthread_mutex_t
+        lock; /**< Mutex protecting b_signaled for blocked threads. */
+    pthread_cond_t cond; /**< Condition variable for blocked threads. */
+    bool b_signaled;     /**< Whether a blocked thread has been signaled. */
+} awaitable_t;
+
+/**
+ * @brief A resumable task with its own small stack.
+ */
+typedef struct coroutine_t
+{
+    ucontext_t     context; /**< Saved context of the coroutine. */
+    ucontext_t     caller;  /**< Context of the worker that resumed it. */
+    threadpool_t * p_pool;  /**< Pool the coroutine runs on. */
+    void (*p_function)(void *); /**< Body of the coroutine. */
+    void *        p_argument;   /**< Pointer to the argument for the body. */
+    void *        p_stack;      /**< Base of the stack mapping. */
+    size_t        stack_size;   /**< Size of the stack mapping. */
+    awaitable_t * p_awaiting;   /**< Awaitable the coroutine suspended on. */
+    bool          b_yielded;    /**< Whether it suspended to yield. */
+    bool          b_finished;   /**< Whether the body has returned. */
+    struct coroutine_t * p_next; /**< Next coroutine a worker resumes itself
+                                      while its pool's queue is full. */
+} coroutine_t;
+
+/**
+ * @brief Initializes an awaitable in the pending state.
+ *
+ * @param p_awaitable A pointer to the awaitable.
+ */
+void awaitable_init (awaitable_t * p_awaitable);
+
+/**
+ * @brief Releases the resources of an awaitable nobody is waiting on.
+ *
+ * @param p_awaitable A pointer to the awaitable.
+ */
+void awaitable_destroy (awaitable_t * p_awaitable);
+
+/**
+ * @brief Completes an awaitable and resumes its waiter, if any. May be called
+ * from any thread, once.
+ *
+ * A waiting coroutine is resubmitted to its pool; it does not run on the
+ * calling thread, except on a worker of the pool whose queue is full, which
+ * resumes the coroutine itself rather than wait for room.
+ *
+ * @param p_awaitable A pointer to the awaitable.
+ * @param p_result Value returned to the waiter by coroutine_await().
+ */
+void awaitable_complete (awaitable_t * p_awaitable, void * p_result);
+
+/**
+ * @brief Starts a coroutine on the pool.
+ *
+ * @param p_pool The pool the coroutine runs on.
+ * @param p_function Body of the coroutine.
+ * @param p_argument Pointer to the argument for the body.
+ * @param stack_size Stack size in bytes, or 0 for
+ * COROUTINE_DEFAULT_STACK_SIZE. A guard page below the stack turns overflows
+ * into a fault.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a pointer is NULL, the pool rejects the task, or in
+ * the event of memory allocation failure.
+ * @note The coroutine counts as outstanding work of the pool until its body
+ * returns, including while it is suspended, so threadpool_drain() waits for
+ * every awaitable it is suspended on to complete. If the pool is stopped with
+ * threadpool_shutdown_now() instead, a suspended coroutine is freed without
+ * resuming when its awaitable completes.
+ */
+int coroutine_spawn (threadpool_t * p_pool,
+                     void (*p_function)(void *),
+                     void * p_argument,
+                     size_t stack_size);
+
+/**
+ * @brief Waits for an awaitable to complete.
+ *
+ * Inside a coroutine the call suspends it and frees the worker until
+ * awaitable_complete() resubmits the coroutine, possibly to another worker.
+ * Outside a coroutine the calling thread blocks.
+ *
+ * @param p_awaitable A pointer to the awaitable. Only one waiter is allowed.
+ * @return The value passed to awaitable_complete(), or NULL if p_awaitable is
+ * NULL.
+ * @warning Thread-local variables read before the call may belong to a
+ * different thread after it.
+ */
+void * coroutine_await (awaitable_t * p_awaitable);
+
+/**
+ * @brief Suspends the calling coroutine and puts it back at the end of its
+ * pool's queue. If the queue is full the worker resumes it again itself.
+ *
+ * @return 0 on success, -1 if not called from a coroutine.
+ */
+int coroutine_yield (void);
+
+/**
+ * @brief Returns the coroutine running on the calling thread.
+ *
+ * @return The running coroutine, or NULL outside coroutines.
+ */
+coroutine_t * coroutine_current (void);
+
+#endif /* COROUTINE_H */
+
+// End of coroutine.h
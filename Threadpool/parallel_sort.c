@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include "parallel_sort.h"
+#include "taskgraph.h"
+
+/**
+ * @brief State shared by every task of one sort.
+ */
+typedef struct parallel_sort_t
+{
+    uint8_t *               p_base;    /**< Elements being sorted. */
+    uint8_t *               p_scratch; /**< Buffer of the same size. */
+    size_t                  elem_size; /**< Size in bytes of one element. */
+    parallel_sort_compare_t p_compare; /**< Ordering function. */
+    void *                  p_context; /**< Argument for p_compare. */
+} parallel_sort_t;
+
+/**
+ * @brief One task: sorts [begin, end) of p_from in place, or merges the
+ * sorted ranges [begin, middle) and [middle, end) of p_from into p_to.
+ */
+typedef struct parallel_sort_job_t
+{
+    parallel_sort_t * p_sort; /**< Sort the job belongs to. */
+    uint8_t *         p_from; /**< Buffer holding the input. */
+    uint8_t *         p_to;   /**< Buffer receiving a merge, or NULL. */
+    size_t            begin;  /**< First element of the range. */
+    size_t            middle; /**< First element of the right run. */
+    size_t            end;    /**< One past the last element of the range. */
+} parallel_sort_job_t;
+
+static void
+parallel_sort_run (void * p_arg)
+{
+    parallel_sort_job_t * p_job  = (parallel_sort_job_t *)p_arg;
+    parallel_sort_t *     p_sort = p_job->p_sort;
+
+    qsort_r(p_job->p_from + (p_job->begin * p_sort->elem_size),
+            p_job->end - p_job->begin,
+            p_sort->elem_size,
+            p_sort->p_compare,
+            p_sort->p_context);
+}
+
+static void
+parallel_sort_merge (void * p_arg)
+{
+    parallel_sort_job_t * p_job     = (parallel_sort_job_t *)p_arg;
+    parallel_sort_t *     p_sort    = p_job->p_sort;
+    size_t                elem_size = p_sort->elem_size;
+    uint8_t *             p_from    = p_job->p_from;
+    uint8_t *             p_left    = p_from + (p_job->begin * elem_size);
+    uint8_t *             p_right   = p_from + (p_job->middle * elem_size);
+    uint8_t *             p_left_end  = p_right;
+    uint8_t *             p_right_end = p_from + (p_job->end * elem_size);
+    uint8_t *             p_out = p_job->p_to + (p_job->begin * elem_size);
+
+    while ((p_left < p_left_end) && (p_right < p_right_end))
+    {
+        // Ties take the left element, so equal keys keep their run order
+        if (0 > p_sort->p_compare(p_right, p_left, p_sort->p_context))
+        {
+            memcpy(p_out, p_right, elem_size);
+            p_right += elem_size;
+        }
+        else
+        {
+            memcpy(p_out, p_left, elem_size);
+            p_left += elem_size;
+        }
+
+        p_out += elem_size;
+    }
+
+    memcpy(p_out, p_left, (size_t)(p_left_end - p_left));
+    p_out += p_left_end - p_left;
+    memcpy(p_out, p_right, (size_t)(p_right_end - p_right));
+}
+
+/**
+ * @brief Builds and runs the graph: num_runs leaf sorts followed by
+ * log2(num_runs) merge levels alternating between the two buffers. Returns
+ * the buffer holding the result, or NULL if the graph could not be run.
+ */
+static uint8_t *
+parallel_sort_graph (threadpool_t *    p_pool,
+                     parallel_sort_t * p_sort,
+                     size_t            count,
+                     size_t            num_runs)
+{
+    uint8_t *             p_result = NULL;
+    size_t                num_jobs = (2 * num_runs) - 1;
+    taskgraph_t *         p_graph  = taskgraph_create();
+    parallel_sort_job_t * p_jobs   = calloc(num_jobs,
+                                          sizeof(parallel_sort_job_t));
+    taskgraph_node_t **   pp_nodes = calloc(num_jobs,
+                                          sizeof(taskgraph_node_t *));
+
+    if ((NULL == p_graph) || (NULL == p_jobs) || (NULL == pp_nodes))
+    {
+        goto EXIT;
+    }
+
+    for (size_t run = 0; run < num_runs; run++)
+    {
+        parallel_sort_job_t * p_job = &p_jobs[run];
+
+        p_job->p_sort = p_sort;
+        p_job->p_from = p_sort->p_base;
+        p_job->begin  = (count * run) / num_runs;
+        p_job->end    = (count * (run + 1)) / num_runs;
+        pp_nodes[run] = taskgraph_add_node(p_graph, parallel_sort_run, p_job);
+
+        if (NULL == pp_nodes[run])
+        {
+            goto EXIT;
+        }
+    }
+
+    // Jobs of one level are stored after those of the previous level; the
+    // children of job (first_child + 2k) and (first_child + 2k + 1) merge
+    // into the next free job
+    uint8_t * p_from      = p_sort->p_base;
+    uint8_t * p_to        = p_sort->p_scratch;
+    size_t    first_child = 0;
+    size_t    next_job    = num_runs;
+
+    for (size_t width = num_runs; width > 1; width /= 2)
+    {
+        for (size_t pair = 0; pair < width; pair += 2)
+        {
+            parallel_sort_job_t * p_left  = &p_jobs[first_child + pair];
+            parallel_sort_job_t * p_right = &p_jobs[first_child + pair + 1];
+            parallel_sort_job_t * p_job   = &p_jobs[next_job];
+
+            p_job->p_sort = p_sort;
+            p_job->p_from = p_from;
+            p_job->p_to   = p_to;
+            p_job->begin  = p_left->begin;
+            p_job->middle = p_right->begin;
+            p_job->end    = p_right->end;
+
+            pp_nodes[next_job]
+                = taskgraph_add_node(p_graph, parallel_sort_merge, p_job);
+
+            if ((NULL == pp_nodes[next_job])
+                || (0
+                    != taskgraph_add_edge(p_graph,
+                                          pp_nodes[first_child + pair],
+                                          pp_nodes[next_job]))
+                || (0
+                    != taskgraph_add_edge(p_graph,
+                                          pp_nodes[first_child + pair + 1],
+                                          pp_nodes[next_job])))
+            {
+                goto EXIT;
+            }
+
+            next_job++;
+        }
+
+        first_child += width;
+
+        uint8_t * p_swap = p_from;
+
+        p_from = p_to;
+        p_to   = p_swap;
+    }
+
+    if (0 == taskgraph_run(p_graph, p_pool))
+    {
+        p_result = p_from;
+    }
+
+EXIT:
+    taskgraph_destroy(p_graph);
+    free(p_jobs);
+    free(pp_nodes);
+
+    return p_result;
+}
+
+int
+parallel_sort (threadpool_t *          p_pool,
+               void *                  p_base,
+               size_t                  count,
+               size_t                  elem_size,
+               parallel_sort_compare_t p_compare,
+               void *                  p_context)
+{
+    int             status   = 0;
+    size_t          num_runs = 1;
+    uint8_t *       p_result = NULL;
+    parallel_sort_t sort;
+
+    if ((0 == elem_size) || ((0 != count) && (NULL == p_base))
+        || ((0 != count) && (NULL == p_compare))
+        || ((SIZE_MAX / elem_size) < count))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    if ((NULL != p_pool) && !threadpool_in_worker(p_pool))
+    {
+        size_t max_runs
+            = (size_t)p_pool->num_threads * PARALLEL_SORT_RUNS_PER_THREAD;
+
+        while (((2 * num_runs) <= max_runs)
+               && ((count / (2 * num_runs)) >= PARALLEL_SORT_MIN_RUN))
+        {
+            num_runs *= 2;
+        }
+    }
+
+    sort.p_base    = (uint8_t *)p_base;
+    sort.p_scratch = NULL;
+    sort.elem_size = elem_size;
+    sort.p_compare = p_compare;
+    sort.p_context = p_context;
+
+    if (1 < num_runs)
+    {
+        sort.p_scratch = malloc(count * elem_size);
+    }
+
+    if (NULL != sort.p_scratch)
+    {
+        p_result = parallel_sort_graph(p_pool, &sort, count, num_runs);
+    }
+
+    if (NULL == p_result)
+    {
+        // Too small to split, or the graph could not be built: the caller's
+        // buffer is untouched or holds sorted runs, so sorting it is enough
+        qsort_r(p_base, count, elem_size, p_compare, p_context);
+    }
+    else if (p_result != sort.p_base)
+    {
+        memcpy(p_base, p_result, count * elem_size);
+    }
+
+    free(sort.p_scratch);
+
+EXIT:
+    return status;
+}
+
+// End of parallel_sort.c
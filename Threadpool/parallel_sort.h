@@ -0,0 +1,69 @@
+/**
+ * @file parallel_sort.h
+ * @brief Defines a merge sort that sorts runs and merges them as a task graph
+ * on a thread pool.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include "threadpool.h"
+
+/**
+ * @brief Defines the fewest elements a run is given before the sort stops
+ * splitting the input further
+ *
+ */
+#define PARALLEL_SORT_MIN_RUN 4096
+
+/**
+ * @brief Defines how many runs are created per pool thread, so that uneven
+ * runs still keep every worker busy
+ *
+ */
+#define PARALLEL_SORT_RUNS_PER_THREAD 4
+
+/**
+ * @brief Ordering function: negative, zero or positive as p_left sorts before,
+ * with, or after p_right.
+ *
+ * @param p_left Pointer to an element.
+ * @param p_right Pointer to an element.
+ * @param p_context The context given to parallel_sort().
+ */
+typedef int (*parallel_sort_compare_t)(const void * p_left,
+                                       const void * p_right,
+                                       void *       p_context);
+
+/**
+ * @brief Sorts count elements of elem_size bytes in place.
+ *
+ * The input is cut into a power-of-two number of runs. Each run is sorted by
+ * its own task, and pairs of runs are merged level by level. Every merge
+ * depends on the two tasks producing its inputs, so all levels form one
+ * taskgraph_run(). Small inputs, calls from one of p_pool's workers, a NULL
+ * pool, and allocation failures all fall back to sorting on the calling
+ * thread. The sort is not stable.
+ *
+ * @param p_pool The pool sorting the runs, or NULL.
+ * @param p_base Pointer to the first element.
+ * @param count Number of elements.
+ * @param elem_size Size in bytes of one element.
+ * @param p_compare Ordering function.
+ * @param p_context Argument passed to every p_compare call.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if p_base or p_compare is NULL while count is not 0,
+ * elem_size is 0, or count * elem_size overflows.
+ */
+int parallel_sort (threadpool_t *          p_pool,
+                   void *                  p_base,
+                   size_t                  count,
+                   size_t                  elem_size,
+                   parallel_sort_compare_t p_compare,
+                   void *                  p_context);
+
+#endif /* PARALLEL_SORT_H */
+
+// End of parallel_sort.h
@@ -0,0 +1,383 @@
+#include "taskgraph.h"
+
+taskgraph_t *
+taskgraph_create (void)
+{
+    taskgraph_t * p_graph = calloc(1, sizeof(taskgraph_t));
+
+    if (NULL == p_graph)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    p_graph->pp_nodes = calloc(TASKGRAPH_INITIAL_CAPACITY,
+                               sizeof(taskgraph_node_t *));
+
+    if (NULL == p_graph->pp_nodes)
+    {
+        free(p_graph);
+        p_graph = NULL;
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    p_graph->num_nodes = 0;
+    p_graph->capacity  = TASKGRAPH_INITIAL_CAPACITY;
+    p_graph->b_running = false;
+    p_graph->b_done    = false;
+    atomic_init(&p_graph->remaining, 0);
+
+    pthread_mutex_init(&p_graph->done_lock, NULL);
+    pthread_cond_init(&p_graph->done, NULL);
+    pthread_mutex_init(&p_graph->ready_lock, NULL);
+
+EXIT:
+    return p_graph;
+}
+
+void
+taskgraph_destroy (taskgraph_t * p_graph)
+{
+    if (NULL != p_graph)
+    {
+        for (size_t index = 0; index < p_graph->num_nodes; index++)
+        {
+            free(p_graph->pp_nodes[index]->pp_successors);
+            free(p_graph->pp_nodes[index]);
+        }
+
+        free(p_graph->pp_nodes);
+        free(p_graph->pp_ready);
+        p_graph->pp_nodes = NULL;
+        p_graph->pp_ready = NULL;
+
+        pthread_mutex_destroy(&p_graph->done_lock);
+        pthread_cond_destroy(&p_graph->done);
+        pthread_mutex_destroy(&p_graph->ready_lock);
+
+        free(p_graph);
+        p_graph = NULL;
+    }
+}
+
+taskgraph_node_t *
+taskgraph_add_node (taskgraph_t * p_graph,
+                    void (*p_task_function)(void *),
+                    void * p_argument)
+{
+    taskgraph_node_t * p_node = NULL;
+
+    if ((NULL == p_graph) || (NULL == p_task_function) || p_graph->b_running)
+    {
+        goto EXIT;
+    }
+
+    if (p_graph->num_nodes == p_graph->capacity)
+    {
+        size_t              new_capacity = 2 * p_graph->capacity;
+        taskgraph_node_t ** pp_temp      = realloc(
+            p_graph->pp_nodes, new_capacity * sizeof(taskgraph_node_t *));
+
+        if (NULL == pp_temp)
+        {
+            fprintf(stderr, "Memory allocation failure.\n");
+            goto EXIT;
+        }
+
+        p_graph->pp_nodes = pp_temp;
+        p_graph->capacity = new_capacity;
+    }
+
+    p_node = calloc(1, sizeof(taskgraph_node_t));
+
+    if (NULL == p_node)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    p_node->p_task_function  = p_task_function;
+    p_node->p_argument       = p_argument;
+    p_node->p_graph          = p_graph;
+    p_node->num_predecessors = 0;
+    atomic_init(&p_node->pending, 0);
+
+    p_graph->pp_nodes[p_graph->num_nodes] = p_node;
+    p_graph->num_nodes++;
+
+EXIT:
+    return p_node;
+}
+
+int
+taskgraph_add_edge (taskgraph_t *      p_graph,
+                    taskgraph_node_t * p_from,
+                    taskgraph_node_t * p_to)
+{
+    int status = 0;
+
+    if ((NULL == p_graph) || (NULL == p_from) || (NULL == p_to)
+        || (p_graph != p_from->p_graph) || (p_graph != p_to->p_graph)
+        || (p_from == p_to) || p_graph->b_running)
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    if (p_from->num_successors == p_from->successor_capacity)
+    {
+        size_t new_capacity = (0 == p_from->successor_capacity)
+                                  ? TASKGRAPH_INITIAL_CAPACITY
+                                  : (2 * p_from->successor_capacity);
+        taskgraph_node_t ** pp_temp = realloc(
+            p_from->pp_successors, new_capacity * sizeof(taskgraph_node_t *));
+
+        if (NULL == pp_temp)
+        {
+            fprintf(stderr, "Memory allocation failure.\n");
+            status = -1;
+            goto EXIT;
+        }
+
+        p_from->pp_successors      = pp_temp;
+        p_from->successor_capacity = new_capacity;
+    }
+
+    p_from->pp_successors[p_from->num_successors] = p_to;
+    p_from->num_successors++;
+    p_to->num_predecessors++;
+
+EXIT:
+    return status;
+}
+
+/**
+ * @brief Checks that the graph has no cycle with Kahn's algorithm, using
+ * each node's pending counter as scratch space.
+ */
+static bool
+taskgraph_is_acyclic (taskgraph_t * p_graph)
+{
+    size_t              visited = 0;
+    size_t              top     = 0;
+    taskgraph_node_t ** pp_stack
+        = malloc((p_graph->num_nodes + 1) * sizeof(taskgraph_node_t *));
+
+    if (NULL == pp_stack)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    for (size_t index = 0; index < p_graph->num_nodes; index++)
+    {
+        taskgraph_node_t * p_node = p_graph->pp_nodes[index];
+
+        atomic_store_explicit(
+            &p_node->pending, p_node->num_predecessors, memory_order_relaxed);
+
+        if (0 == p_node->num_predecessors)
+        {
+            pp_stack[top] = p_node;
+            top++;
+        }
+    }
+
+    while (0 < top)
+    {
+        top--;
+        taskgraph_node_t * p_node = pp_stack[top];
+        visited++;
+
+        for (size_t index = 0; index < p_node->num_successors; index++)
+        {
+            taskgraph_node_t * p_next = p_node->pp_successors[index];
+
+            if (1
+                == atomic_fetch_sub_explicit(
+                    &p_next->pending, 1, memory_order_relaxed))
+            {
+                pp_stack[top] = p_next;
+                top++;
+            }
+        }
+    }
+
+    free(pp_stack);
+
+EXIT:
+    return (visited == p_graph->num_nodes);
+}
+
+static void
+taskgraph_push_ready (taskgraph_t * p_graph, taskgraph_node_t * p_node)
+{
+    pthread_mutex_lock(&p_graph->ready_lock);
+    p_graph->pp_ready[p_graph->num_ready] = p_node;
+    p_graph->num_ready++;
+    pthread_mutex_unlock(&p_graph->ready_lock);
+}
+
+static taskgraph_node_t *
+taskgraph_pop_ready (taskgraph_t * p_graph)
+{
+    taskgraph_node_t * p_node = NULL;
+
+    pthread_mutex_lock(&p_graph->ready_lock);
+
+    if (0 < p_graph->num_ready)
+    {
+        p_graph->num_ready--;
+        p_node = p_graph->pp_ready[p_graph->num_ready];
+    }
+
+    pthread_mutex_unlock(&p_graph->ready_lock);
+
+    return p_node;
+}
+
+static void
+taskgraph_node_run (void * p_arg)
+{
+    taskgraph_node_t * p_node  = (taskgraph_node_t *)p_arg;
+    taskgraph_t *      p_graph = p_node->p_graph;
+
+    while (NULL != p_node)
+    {
+        taskgraph_node_t * p_next = NULL;
+
+        p_node->p_task_function(p_node->p_argument);
+
+        for (size_t index = 0; index < p_node->num_successors; index++)
+        {
+            taskgraph_node_t * p_successor = p_node->pp_successors[index];
+
+            // acq_rel: the successor must see the writes of every predecessor
+            if (1
+                != atomic_fetch_sub_explicit(
+                    &p_successor->pending, 1, memory_order_acq_rel))
+            {
+                continue;
+            }
+
+            if (NULL == p_next)
+            {
+                p_next = p_successor;
+            }
+            else if (0
+                     != threadpool_task_try_submit(
+                         p_graph->p_pool, taskgraph_node_run, p_successor))
+            {
+                taskgraph_push_ready(p_graph, p_successor);
+            }
+        }
+
+        if (NULL == p_next)
+        {
+            p_next = taskgraph_pop_ready(p_graph);
+        }
+
+        // The caller may free the graph once it sees b_done, so b_done is
+        // only set under the lock and the graph is not touched afterwards
+        if (1 == atomic_fetch_sub(&p_graph->remaining, 1))
+        {
+            pthread_mutex_lock(&p_graph->done_lock);
+            p_graph->b_done = true;
+            pthread_cond_broadcast(&p_graph->done);
+            pthread_mutex_unlock(&p_graph->done_lock);
+        }
+
+        p_node = p_next;
+    }
+}
+
+int
+taskgraph_run (taskgraph_t * p_graph, threadpool_t * p_pool)
+{
+    int status = 0;
+
+    if ((NULL == p_graph) || (NULL == p_pool) || p_graph->b_running
+        || threadpool_in_worker(p_pool))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    if (0 == p_graph->num_nodes)
+    {
+        goto EXIT;
+    }
+
+    if (!taskgraph_is_acyclic(p_graph))
+    {
+        fprintf(stderr, "Task graph contains a cycle.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    // Every node becomes ready exactly once per run, which bounds pp_ready
+    taskgraph_node_t ** pp_ready = realloc(
+        p_graph->pp_ready, p_graph->num_nodes * sizeof(taskgraph_node_t *));
+
+    if (NULL == pp_ready)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    p_graph->pp_ready  = pp_ready;
+    p_graph->num_ready = 0;
+    p_graph->p_pool    = p_pool;
+    p_graph->b_running = true;
+    p_graph->b_done    = false;
+
+    for (size_t index = 0; index < p_graph->num_nodes; index++)
+    {
+        taskgraph_node_t * p_node = p_graph->pp_nodes[index];
+
+        atomic_store_explicit(
+            &p_node->pending, p_node->num_predecessors, memory_order_relaxed);
+    }
+
+    atomic_store(&p_graph->remaining, p_graph->num_nodes);
+
+    for (size_t index = 0; index < p_graph->num_nodes; index++)
+    {
+        taskgraph_node_t * p_node = p_graph->pp_nodes[index];
+
+        if ((0 == p_node->num_predecessors)
+            && (0
+                != threadpool_task_try_submit(
+                    p_pool, taskgraph_node_run, p_node)))
+        {
+            taskgraph_push_ready(p_graph, p_node);
+        }
+    }
+
+    // Help with roots the queues could not take; afterwards every parked node
+    // is picked up by a thread that is still running nodes
+    for (taskgraph_node_t * p_node = taskgraph_pop_ready(p_graph);
+         NULL != p_node;
+         p_node = taskgraph_pop_ready(p_graph))
+    {
+        taskgraph_node_run(p_node);
+    }
+
+    pthread_mutex_lock(&p_graph->done_lock);
+
+    while (!p_graph->b_done)
+    {
+        pthread_cond_wait(&p_graph->done, &p_graph->done_lock);
+    }
+
+    pthread_mutex_unlock(&p_graph->done_lock);
+
+    p_graph->b_running = false;
+
+EXIT:
+    return status;
+}
+
+// End of taskgraph.c
@@ -0,0 +1,129 @@
+/**
+ * @file taskgraph.h
+ * @brief Defines a task dependency graph (DAG) executed on a thread pool.
+ * @author Taylor Bradley
+ * @date 2026-10-19
+ */
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include "threadpool.h"
+
+/**
+ * @brief Defines the initial node and successor capacity of a graph
+ *
+ */
+#define TASKGRAPH_INITIAL_CAPACITY 8
+
+struct taskgraph_t;
+
+/**
+ * @brief A task in a graph together with its outgoing edges.
+ */
+typedef struct taskgraph_node_t
+{
+    void (*p_task_function)(void *); /**< Pointer to the task function. */
+    void * p_argument; /**< Pointer to the argument for the task function. */
+    struct taskgraph_node_t **
+           pp_successors;  /**< Nodes that depend on this node. */
+    size_t num_successors; /**< Number of entries in pp_successors. */
+    size_t successor_capacity; /**< Capacity of pp_successors. */
+    size_t num_predecessors;   /**< Number of nodes this node depends on. */
+    atomic_size_t pending; /**< Predecessors not yet finished in the current
+                              run. */
+    struct taskgraph_t * p_graph; /**< Graph owning the node. */
+} taskgraph_node_t;
+
+/**
+ * @brief A reusable directed acyclic graph of tasks.
+ */
+typedef struct taskgraph_t
+{
+    taskgraph_node_t ** pp_nodes;  /**< Nodes of the graph. */
+    size_t              num_nodes; /**< Number of nodes in the graph. */
+    size_t              capacity;  /**< Capacity of pp_nodes. */
+    threadpool_t *      p_pool;    /**< Pool executing the current run. */
+    atomic_size_t remaining; /**< Nodes not yet finished in the current run. */
+    pthread_mutex_t
+        done_lock; /**< Mutex protecting the done condition variable. */
+    pthread_cond_t done; /**< Condition variable signaling the end of a run. */
+    pthread_mutex_t
+        ready_lock; /**< Mutex for thread-safe access to pp_ready. */
+    taskgraph_node_t ** pp_ready; /**< Ready nodes that did not fit in the
+                                       pool's queues. */
+    size_t num_ready;  /**< Number of entries in pp_ready. */
+    bool   b_running;  /**< Whether a run is in progress. */
+    bool   b_done; /**< Whether the current run has finished, protected by
+                        done_lock. */
+} taskgraph_t;
+
+/**
+ * @brief Creates an empty task graph.
+ *
+ * @return A pointer to the new graph, or NULL.
+ * @warning Returns NULL in the event of memory allocation failure.
+ */
+taskgraph_t * taskgraph_create (void);
+
+/**
+ * @brief Frees a graph and all of its nodes. The tasks' arguments are not
+ * freed.
+ *
+ * @param p_graph A pointer to the graph.
+ */
+void taskgraph_destroy (taskgraph_t * p_graph);
+
+/**
+ * @brief Adds a task to the graph.
+ *
+ * @param p_graph A pointer to the graph.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @return A pointer to the new node, owned by the graph, or NULL.
+ * @warning Returns NULL if a pointer is NULL, the graph is running, or in the
+ * event of memory allocation failure.
+ */
+taskgraph_node_t * taskgraph_add_node (taskgraph_t * p_graph,
+                                       void (*p_task_function)(void *),
+                                       void * p_argument);
+
+/**
+ * @brief Makes p_to depend on p_from: p_to starts only after p_from has
+ * finished.
+ *
+ * @param p_graph A pointer to the graph.
+ * @param p_from The node that must finish first.
+ * @param p_to The dependent node.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a pointer is NULL, either node belongs to
+ * another graph, the edge is a self-loop, the graph is running, or in the
+ * event of memory allocation failure.
+ */
+int taskgraph_add_edge (taskgraph_t *      p_graph,
+                        taskgraph_node_t * p_from,
+                        taskgraph_node_t * p_to);
+
+/**
+ * @brief Executes every node of the graph on the pool, respecting its edges,
+ * and blocks until all have finished.
+ *
+ * Each node holds an atomic count of unfinished predecessors. The worker that
+ * finishes a node's last predecessor releases it: it keeps one released node
+ * to run next itself and submits the rest, so no coordinator thread is
+ * involved. Released nodes that do not fit in the pool's queues are parked in
+ * the graph and picked up by the next thread to finish a node, including the
+ * caller, so a run never blocks on a full queue.
+ *
+ * @param p_graph A pointer to the graph.
+ * @param p_pool The pool executing the tasks.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a pointer is NULL, the graph contains a cycle or
+ * is already running, the caller is one of p_pool's workers, or in the event
+ * of memory allocation failure.
+ */
+int taskgraph_run (taskgraph_t * p_graph, threadpool_t * p_pool);
+
+#endif /* TASKGRAPH_H */
+
+// End of taskgraph.h
@@ -1,195 +1,1951 @@
+#define _GNU_SOURCE
 #include "threadpool.h"
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+
+#define THREADPOOL_NS_PER_SEC 1000000000u /**< Nanoseconds per second. */
+#define THREADPOOL_NS_PER_MS  1000000u    /**< Nanoseconds per millisecond. */
+#define THREADPOOL_TIMER_INITIAL_CAPACITY 16 /**< First timer heap size. */
+
+#define THREADPOOL_CPULIST_LENGTH 1024 /**< Longest sysfs cpulist accepted. */
+
+/**
+ * @brief Worker running on the calling thread, or NULL for non-pool threads.
+ */
+static _Thread_local threadpool_worker_t * gp_current_worker = NULL;
+
+static void * threadpool_worker_main (void * p_arg);
+
+static uint64_t
+threadpool_now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * THREADPOOL_NS_PER_SEC)
+           + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Allocates zeroed, cache-line aligned memory for the pool's
+ * structures, whose alignment exceeds what calloc() guarantees. Release with
+ * free().
+ */
+static void *
+threadpool_aligned_calloc (size_t count, size_t size)
+{
+    void * p_memory = NULL;
+    size_t total    = count * size;
+
+    if ((0 != count) && ((total / count) != size))
+    {
+        goto EXIT;
+    }
+
+    if (0 != posix_memalign(&p_memory, THREADPOOL_CACHE_LINE, total))
+    {
+        p_memory = NULL;
+        goto EXIT;
+    }
+
+    memset(p_memory, 0, total);
+
+EXIT:
+    return p_memory;
+}
+
+/**
+ * @brief Adds to a counter that only the calling thread writes, avoiding a
+ * locked read-modify-write.
+ */
+static void
+threadpool_counter_add (atomic_uint_least64_t * p_counter, uint64_t value)
+{
+    uint64_t current = atomic_load_explicit(p_counter, memory_order_relaxed);
+
+    atomic_store_explicit(p_counter, current + value, memory_order_relaxed);
+}
+
+static size_t
+threadpool_histogram_bucket (uint64_t value)
+{
+    size_t bucket = (size_t)value;
+
+    if ((1u << THREADPOOL_HISTOGRAM_SUB_BITS) <= value)
+    {
+        int magnitude = 63 - __builtin_clzll(value);
+        int shift     = magnitude - THREADPOOL_HISTOGRAM_SUB_BITS;
+
+        bucket = ((size_t)(shift + 1) << THREADPOOL_HISTOGRAM_SUB_BITS)
+                 + (size_t)((value >> shift)
+                            & ((1u << THREADPOOL_HISTOGRAM_SUB_BITS) - 1));
+    }
+
+    return bucket;
+}
+
+static uint64_t
+threadpool_histogram_bucket_value (size_t bucket)
+{
+    uint64_t value = (uint64_t)bucket;
+
+    if ((1u << THREADPOOL_HISTOGRAM_SUB_BITS) <= bucket)
+    {
+        int      shift = (int)(bucket >> THREADPOOL_HISTOGRAM_SUB_BITS) - 1;
+        uint64_t sub   = bucket & ((1u << THREADPOOL_HISTOGRAM_SUB_BITS) - 1);
+
+        value = ((1u << THREADPOOL_HISTOGRAM_SUB_BITS) + sub) << shift;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Parses a sysfs cpulist ("0-3,8,10-11") and stores the CPUs that are
+ * also set in p_allowed.
+ *
+ * @return The number of CPUs stored in p_cpus.
+ */
+static int
+threadpool_parse_cpulist (const char *      p_list,
+                          const cpu_set_t * p_allowed,
+                          int *             p_cpus,
+                          int               max_cpus)
+{
+    int          count  = 0;
+    const char * p_next = p_list;
+
+    while (('\0' != *p_next) && ('\n' != *p_next))
+    {
+        char * p_end = NULL;
+        long   first = strtol(p_next, &p_end, 10);
+        long   last  = first;
+
+        if (p_end == p_next)
+        {
+            break;
+        }
+
+        if ('-' == *p_end)
+        {
+            p_next = p_end + 1;
+            last   = strtol(p_next, &p_end, 10);
+        }
+
+        for (long cpu = first; (cpu <= last) && (count < max_cpus); cpu++)
+        {
+            if ((0 <= cpu) && (CPU_SETSIZE > cpu) && CPU_ISSET(cpu, p_allowed))
+            {
+                p_cpus[count] = (int)cpu;
+                count++;
+            }
+        }
+
+        p_next = (',' == *p_end) ? (p_end + 1) : p_end;
+    }
+
+    return count;
+}
+
+static int
+threadpool_queue_init (threadpool_queue_t * p_queue,
+                       int                  capacity,
+                       int                  node,
+                       const int *          p_cpus,
+                       int                  num_cpus)
+{
+    int status = 0;
+
+    p_queue->p_tasks = malloc(sizeof(task_t) * capacity);
+    p_queue->p_cpus  = malloc(sizeof(int) * (num_cpus > 0 ? num_cpus : 1));
+
+    if ((NULL == p_queue->p_tasks) || (NULL == p_queue->p_cpus))
+    {
+        free(p_queue->p_tasks);
+        free(p_queue->p_cpus);
+        p_queue->p_tasks = NULL;
+        p_queue->p_cpus  = NULL;
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    memcpy(p_queue->p_cpus, p_cpus, sizeof(int) * num_cpus);
+
+    p_queue->capacity   = capacity;
+    p_queue->node       = node;
+    p_queue->num_cpus   = num_cpus;
+    p_queue->high_water = 0;
+
+    atomic_init(&p_queue->rear, 0);
+    atomic_init(&p_queue->front, 0);
+    atomic_init(&p_queue->num_blocked, 0);
+    atomic_init(&p_queue->num_idle, 0);
+    atomic_init(&p_queue->blocked_count, 0);
+    atomic_init(&p_queue->blocked_ns, 0);
+
+    pthread_condattr_t cond_attr;
+
+    // Timer deadlines are monotonic, so idle workers wait on that clock
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&p_queue->push_lock, NULL);
+    pthread_mutex_init(&p_queue->pop_lock, NULL);
+    pthread_cond_init(&p_queue->not_empty, &cond_attr);
+    pthread_cond_init(&p_queue->not_full, &cond_attr);
+
+    pthread_condattr_destroy(&cond_attr);
+
+EXIT:
+    return status;
+}
+
+static void
+threadpool_queue_destroy (threadpool_queue_t * p_queue)
+{
+    free(p_queue->p_tasks);
+    free(p_queue->p_cpus);
+    p_queue->p_tasks = NULL;
+    p_queue->p_cpus  = NULL;
+
+    pthread_mutex_destroy(&p_queue->push_lock);
+    pthread_mutex_destroy(&p_queue->pop_lock);
+    pthread_cond_destroy(&p_queue->not_empty);
+    pthread_cond_destroy(&p_queue->not_full);
+}
+
+static void
+threadpool_free_queues (threadpool_t * p_pool)
+{
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_destroy(&p_pool->p_queues[index]);
+    }
+
+    free(p_pool->p_queues);
+    free(p_pool->p_cpu_queue);
+    p_pool->p_queues    = NULL;
+    p_pool->p_cpu_queue = NULL;
+    p_pool->num_queues  = 0;
+}
+
+static void
+threadpool_free_workers (threadpool_t * p_pool)
+{
+    if (NULL != p_pool->p_workers)
+    {
+        for (int index = 0; index < p_pool->num_threads; index++)
+        {
+            free(p_pool->p_workers[index].p_stats);
+        }
+
+        free(p_pool->p_workers);
+        p_pool->p_workers = NULL;
+    }
+}
+
+static void
+threadpool_free_sync (threadpool_t * p_pool)
+{
+    pthread_mutex_destroy(&p_pool->idle_lock);
+    pthread_cond_destroy(&p_pool->idle);
+    pthread_mutex_destroy(&p_pool->control_lock);
+    pthread_mutex_destroy(&p_pool->timer_lock);
+
+    free(p_pool->p_timers);
+    p_pool->p_timers   = NULL;
+    p_pool->num_timers = 0;
+}
+
+/**
+ * @brief Creates one queue per NUMA node usable by the process, limited to
+ * max_queues. Falls back to a single queue holding every allowed CPU when the
+ * topology is unavailable or b_numa_aware is false.
+ */
+static int
+threadpool_create_queues (threadpool_t * p_pool,
+                          bool           b_numa_aware,
+                          int            max_queues,
+                          int            capacity)
+{
+    int       status = 0;
+    cpu_set_t allowed;
+    int *     p_cpus = malloc(sizeof(int) * CPU_SETSIZE);
+
+    p_pool->num_queues = 0;
+    p_pool->p_queues
+        = threadpool_aligned_calloc(max_queues, sizeof(threadpool_queue_t));
+
+    if ((NULL == p_cpus) || (NULL == p_pool->p_queues))
+    {
+        free(p_pool->p_queues);
+        p_pool->p_queues = NULL;
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    CPU_ZERO(&allowed);
+
+    if (0 != sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+        for (long cpu = 0; (cpu < online) && (CPU_SETSIZE > cpu); cpu++)
+        {
+            CPU_SET(cpu, &allowed);
+        }
+    }
+
+    for (int node = 0; b_numa_aware && (node < THREADPOOL_MAX_NODES)
+                       && (p_pool->num_queues < max_queues);
+         node++)
+    {
+        char   path[64];
+        char   list[THREADPOOL_CPULIST_LENGTH];
+        FILE * p_file = NULL;
+
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/node/node%d/cpulist",
+                 node);
+        p_file = fopen(path, "r");
+
+        if (NULL == p_file)
+        {
+            continue;
+        }
+
+        int num_cpus = 0;
+
+        if (NULL != fgets(list, sizeof(list), p_file))
+        {
+            num_cpus
+                = threadpool_parse_cpulist(list, &allowed, p_cpus, CPU_SETSIZE);
+        }
+
+        fclose(p_file);
+
+        // Memory-only nodes and nodes outside our cpuset get no queue
+        if (0 == num_cpus)
+        {
+            continue;
+        }
+
+        if (0
+            != threadpool_queue_init(&p_pool->p_queues[p_pool->num_queues],
+                                     capacity,
+                                     node,
+                                     p_cpus,
+                                     num_cpus))
+        {
+            status = -1;
+            goto EXIT;
+        }
+
+        p_pool->num_queues++;
+    }
+
+    if (0 == p_pool->num_queues)
+    {
+        int num_cpus = 0;
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &allowed))
+            {
+                p_cpus[num_cpus] = cpu;
+                num_cpus++;
+            }
+        }
+
+        if (0
+            != threadpool_queue_init(
+                &p_pool->p_queues[0], capacity, 0, p_cpus, num_cpus))
+        {
+            status = -1;
+            goto EXIT;
+        }
+
+        p_pool->num_queues = 1;
+    }
+
+    // Build the CPU -> queue map used to route submissions from non-workers
+    p_pool->num_cpu_ids = 0;
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        for (int cpu = 0; cpu < p_queue->num_cpus; cpu++)
+        {
+            if (p_queue->p_cpus[cpu] >= p_pool->num_cpu_ids)
+            {
+                p_pool->num_cpu_ids = p_queue->p_cpus[cpu] + 1;
+            }
+        }
+    }
+
+    p_pool->p_cpu_queue = malloc(sizeof(int) * (p_pool->num_cpu_ids + 1));
+
+    if (NULL == p_pool->p_cpu_queue)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        status = -1;
+        goto EXIT;
+    }
+
+    for (int cpu = 0; cpu < p_pool->num_cpu_ids; cpu++)
+    {
+        p_pool->p_cpu_queue[cpu] = -1;
+    }
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        for (int cpu = 0; cpu < p_queue->num_cpus; cpu++)
+        {
+            p_pool->p_cpu_queue[p_queue->p_cpus[cpu]] = index;
+        }
+    }
+
+EXIT:
+    if ((0 != status) && (NULL != p_pool->p_queues))
+    {
+        threadpool_free_queues(p_pool);
+    }
+
+    free(p_cpus);
+    return status;
+}
+
+/**
+ * @brief Restricts a worker about to be created to its node, or to a single
+ * CPU of that node when pinning is requested. Affinity is set on the thread
+ * attributes so the worker's first allocations already happen on its node.
+ */
+static void
+threadpool_worker_affinity (threadpool_worker_t *     p_worker,
+                            const threadpool_attr_t * p_attr,
+                            pthread_attr_t *          p_thread_attr)
+{
+    threadpool_queue_t * p_queue = p_worker->p_queue;
+    int                  rank    = p_worker->id / p_worker->p_pool->num_queues;
+    cpu_set_t            cpus;
+
+    p_worker->cpu = -1;
+    CPU_ZERO(&cpus);
+
+    if (p_attr->b_pin_workers)
+    {
+        p_worker->cpu = p_queue->p_cpus[rank % p_queue->num_cpus];
+        CPU_SET(p_worker->cpu, &cpus);
+    }
+    else if (p_attr->b_numa_aware && (1 < p_worker->p_pool->num_queues))
+    {
+        for (int index = 0; index < p_queue->num_cpus; index++)
+        {
+            CPU_SET(p_queue->p_cpus[index], &cpus);
+        }
+    }
+    else
+    {
+        goto EXIT;
+    }
+
+    if (0 != pthread_attr_setaffinity_np(p_thread_attr, sizeof(cpus), &cpus))
+    {
+        fprintf(stderr, "Worker affinity not applied.\n");
+        p_worker->cpu = -1;
+    }
+
+EXIT:
+    return;
+}
 
 threadpool_t *
 threadpool_init (int num_threads)
 {
-    threadpool_t * p_pool = malloc(sizeof(threadpool_t));
+    threadpool_attr_t attr = { 0 };
+
+    return threadpool_init_attr(num_threads, &attr);
+}
+
+threadpool_t *
+threadpool_init_attr (int num_threads, const threadpool_attr_t * p_attr)
+{
+    threadpool_attr_t default_attr = { 0 };
+    threadpool_t *    p_pool       = NULL;
+
+    if (NULL == p_attr)
+    {
+        p_attr = &default_attr;
+    }
+
+    if (0 >= num_threads)
+    {
+        fprintf(stderr, "Thread pool needs at least one thread.\n");
+        goto EXIT;
+    }
+
+    p_pool = threadpool_aligned_calloc(1, sizeof(threadpool_t));
+
+    if (NULL == p_pool)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    int capacity = (0 < p_attr->queue_capacity) ? p_attr->queue_capacity
+                                                : THREAD_POOL_SIZE;
+    int max_queues
+        = (THREADPOOL_MAX_NODES < num_threads) ? THREADPOOL_MAX_NODES
+                                               : num_threads;
+
+    if (0
+        != threadpool_create_queues(
+            p_pool, p_attr->b_numa_aware, max_queues, capacity))
+    {
+        free(p_pool);
+        p_pool = NULL;
+        goto EXIT;
+    }
+
+    atomic_init(&p_pool->next_queue, 0);
+    atomic_init(&p_pool->state, THREADPOOL_RUNNING);
+    atomic_init(&p_pool->outstanding, 0);
+    p_pool->b_joined    = false;
+    p_pool->b_telemetry = p_attr->b_telemetry;
+
+    pthread_mutex_init(&p_pool->idle_lock, NULL);
+    pthread_cond_init(&p_pool->idle, NULL);
+    pthread_mutex_init(&p_pool->control_lock, NULL);
+    pthread_mutex_init(&p_pool->timer_lock, NULL);
+
+    p_pool->p_timers       = NULL;
+    p_pool->num_timers     = 0;
+    p_pool->timer_capacity = 0;
+    p_pool->next_timer_id  = 0;
+    atomic_init(&p_pool->next_deadline_ns, UINT64_MAX);
+
+    p_pool->p_workers
+        = threadpool_aligned_calloc(num_threads, sizeof(threadpool_worker_t));
+    p_pool->num_threads = num_threads;
+
+    for (int index = 0; p_pool->b_telemetry && (NULL != p_pool->p_workers)
+                        && (index < num_threads);
+         index++)
+    {
+        threadpool_worker_t * p_worker = &p_pool->p_workers[index];
+
+        p_worker->p_stats
+            = threadpool_aligned_calloc(1, sizeof(threadpool_stats_t));
+
+        if (NULL == p_worker->p_stats)
+        {
+            threadpool_free_workers(p_pool);
+        }
+    }
+
+    if (NULL == p_pool->p_workers)
+    {
+        threadpool_free_sync(p_pool);
+        threadpool_free_queues(p_pool);
+        free(p_pool);
+        p_pool = NULL;
+        fprintf(stderr, "Memory allocation failure.\n");
+        goto EXIT;
+    }
+
+    int count = 0;
+
+    for (int index = 0; index < num_threads; index++)
+    {
+        threadpool_worker_t * p_worker = &p_pool->p_workers[index];
+        pthread_attr_t        thread_attr;
+
+        p_worker->p_pool  = p_pool;
+        p_worker->id      = index;
+        p_worker->p_queue = &p_pool->p_queues[index % p_pool->num_queues];
+
+        pthread_attr_init(&thread_attr);
+        threadpool_worker_affinity(p_worker, p_attr, &thread_attr);
+
+        int create_status = pthread_create(
+            &p_worker->thread, &thread_attr, threadpool_worker_main, p_worker);
+
+        pthread_attr_destroy(&thread_attr);
+
+        if (0 != create_status)
+        {
+            fprintf(stderr, "Thread create failure.\n");
+
+            for (int thread = 0; thread < index; thread++)
+            {
+                pthread_cancel(p_pool->p_workers[thread].thread);
+            }
+
+            for (int thread = 0; thread < index; thread++)
+            {
+                pthread_join(p_pool->p_workers[thread].thread, NULL);
+            }
+
+            threadpool_free_workers(p_pool);
+            threadpool_free_sync(p_pool);
+            threadpool_free_queues(p_pool);
+            free(p_pool);
+            p_pool = NULL;
+            goto EXIT;
+        }
+
+        count++;
+    }
+
+    p_pool->num_threads = count;
+
+EXIT:
+    return p_pool;
+}
+
+void
+threadpool_destroy (threadpool_t * p_pool)
+{
+    if (NULL != p_pool)
+    {
+        printf("Wrapping up threads...\n");
+
+        // A worker cannot drain its own pool, and the workers must be gone
+        // before anything they use is freed
+        if (0 != threadpool_drain(p_pool))
+        {
+            fprintf(stderr, "A pool cannot be destroyed by its own worker.\n");
+            goto EXIT;
+        }
+
+        threadpool_free_workers(p_pool);
+        threadpool_free_sync(p_pool);
+        threadpool_free_queues(p_pool);
+
+        free(p_pool);
+        p_pool = NULL;
+    }
+
+EXIT:
+    return;
+}
+
+/**
+ * @brief Returns true when the calling thread is one of p_pool's workers.
+ */
+static bool
+threadpool_is_own_worker (threadpool_t * p_pool)
+{
+    return ((NULL != gp_current_worker)
+            && (p_pool == gp_current_worker->p_pool));
+}
+
+/**
+ * @brief Marks one outstanding task as finished, waking idle waiters when it
+ * was the last one.
+ */
+static void
+threadpool_task_done (threadpool_t * p_pool)
+{
+    if (1 == atomic_fetch_sub(&p_pool->outstanding, 1))
+    {
+        pthread_mutex_lock(&p_pool->idle_lock);
+        pthread_cond_broadcast(&p_pool->idle);
+        pthread_mutex_unlock(&p_pool->idle_lock);
+    }
+}
+
+/**
+ * @brief Discards every armed timer once the pool has left
+ * THREADPOOL_RUNNING, so that idle workers stop waking for deadlines that
+ * will never be serviced.
+ */
+static void
+threadpool_timers_discard (threadpool_t * p_pool)
+{
+    pthread_mutex_lock(&p_pool->timer_lock);
+    p_pool->num_timers = 0;
+    atomic_store(&p_pool->next_deadline_ns, UINT64_MAX);
+    pthread_mutex_unlock(&p_pool->timer_lock);
+}
+
+/**
+ * @brief Moves the pool to THREADPOOL_STOPPED, wakes every sleeping worker
+ * and producer, and joins the workers once.
+ */
+static void
+threadpool_stop_workers (threadpool_t * p_pool)
+{
+    pthread_mutex_lock(&p_pool->control_lock);
+
+    if (p_pool->b_joined)
+    {
+        goto EXIT_UNLOCK;
+    }
+
+    atomic_store(&p_pool->state, THREADPOOL_STOPPED);
+    threadpool_timers_discard(p_pool);
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        pthread_mutex_lock(&p_queue->pop_lock);
+        pthread_cond_broadcast(&p_queue->not_empty);
+        pthread_mutex_unlock(&p_queue->pop_lock);
+
+        pthread_mutex_lock(&p_queue->push_lock);
+        pthread_cond_broadcast(&p_queue->not_full);
+        pthread_mutex_unlock(&p_queue->push_lock);
+    }
+
+    for (int index = 0; index < p_pool->num_threads; index++)
+    {
+        pthread_join(p_pool->p_workers[index].thread, NULL);
+    }
+
+    p_pool->b_joined = true;
+
+EXIT_UNLOCK:
+    pthread_mutex_unlock(&p_pool->control_lock);
+}
+
+int
+threadpool_wait_idle (threadpool_t * p_pool)
+{
+    int status = 0;
+
+    if ((NULL == p_pool) || threadpool_is_own_worker(p_pool))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_pool->idle_lock);
+
+    while (0 != atomic_load(&p_pool->outstanding))
+    {
+        pthread_cond_wait(&p_pool->idle, &p_pool->idle_lock);
+    }
+
+    pthread_mutex_unlock(&p_pool->idle_lock);
+
+EXIT:
+    return status;
+}
+
+int
+threadpool_drain (threadpool_t * p_pool)
+{
+    int status = 0;
+
+    if ((NULL == p_pool) || threadpool_is_own_worker(p_pool))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    int expected = THREADPOOL_RUNNING;
+    atomic_compare_exchange_strong(
+        &p_pool->state, &expected, THREADPOOL_DRAINING);
+    threadpool_timers_discard(p_pool);
+
+    // Only workers can still submit, so once nothing is outstanding nothing
+    // new can arrive either
+    if (THREADPOOL_STOPPED != expected)
+    {
+        threadpool_wait_idle(p_pool);
+    }
+
+    threadpool_stop_workers(p_pool);
+
+EXIT:
+    return status;
+}
+
+task_t *
+threadpool_shutdown_now (threadpool_t * p_pool, size_t * p_count)
+{
+    task_t * p_tasks = NULL;
+    size_t   count   = 0;
+
+    if ((NULL == p_pool) || (NULL == p_count)
+        || threadpool_is_own_worker(p_pool))
+    {
+        goto EXIT;
+    }
+
+    threadpool_stop_workers(p_pool);
+
+    size_t total = 0;
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        total += (size_t)threadpool_queue_size(&p_pool->p_queues[index]);
+    }
+
+    if (0 == total)
+    {
+        goto EXIT;
+    }
+
+    p_tasks = malloc(sizeof(task_t) * total);
+
+    if (NULL == p_tasks)
+    {
+        fprintf(stderr, "Memory allocation failure.\n");
+    }
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        pthread_mutex_lock(&p_queue->pop_lock);
+
+        while (0 < threadpool_queue_size(p_queue))
+        {
+            task_t task = threadpool_queue_pop(p_queue);
+
+            if (NULL != p_tasks)
+            {
+                p_tasks[count] = task;
+                count++;
+            }
+
+            threadpool_task_done(p_pool);
+        }
+
+        pthread_mutex_unlock(&p_queue->pop_lock);
+    }
+
+EXIT:
+    if (NULL != p_count)
+    {
+        *p_count = count;
+    }
+
+    return p_tasks;
+}
+
+int
+threadpool_queue_size (threadpool_queue_t * p_queue)
+{
+    // front first: it never passes a rear read after it
+    uint64_t front = atomic_load(&p_queue->front);
+    uint64_t rear  = atomic_load(&p_queue->rear);
+
+    return (int)(rear - front);
+}
+
+void
+threadpool_queue_push (threadpool_queue_t * p_queue, task_t task)
+{
+    uint64_t rear = atomic_load_explicit(&p_queue->rear, memory_order_relaxed);
+
+    p_queue->p_tasks[rear % (uint64_t)p_queue->capacity] = task;
+    atomic_store(&p_queue->rear, rear + 1);
+
+    int depth = threadpool_queue_size(p_queue);
+
+    if (depth > p_queue->high_water)
+    {
+        p_queue->high_water = depth;
+    }
+}
+
+task_t
+threadpool_queue_pop (threadpool_queue_t * p_queue)
+{
+    uint64_t front
+        = atomic_load_explicit(&p_queue->front, memory_order_relaxed);
+    task_t task = p_queue->p_tasks[front % (uint64_t)p_queue->capacity];
+
+    atomic_store(&p_queue->front, front + 1);
+
+    return task;
+}
+
+/**
+ * @brief Wakes a worker asleep on p_queue after a push. A worker bumps
+ * num_idle before its last emptiness check and the producer publishes rear
+ * before reading num_idle; both are sequentially consistent, so either the
+ * worker sees the task or the producer sees the worker.
+ */
+static void
+threadpool_queue_wake_consumer (threadpool_queue_t * p_queue)
+{
+    if (0 < atomic_load(&p_queue->num_idle))
+    {
+        pthread_mutex_lock(&p_queue->pop_lock);
+        pthread_cond_signal(&p_queue->not_empty);
+        pthread_mutex_unlock(&p_queue->pop_lock);
+    }
+}
+
+/**
+ * @brief Wakes a producer asleep on p_queue after a pop, by the same protocol
+ * on num_blocked and front.
+ */
+static void
+threadpool_queue_wake_producer (threadpool_queue_t * p_queue)
+{
+    if (0 < atomic_load(&p_queue->num_blocked))
+    {
+        pthread_mutex_lock(&p_queue->push_lock);
+        pthread_cond_signal(&p_queue->not_full);
+        pthread_mutex_unlock(&p_queue->push_lock);
+    }
+}
+
+/**
+ * @brief Picks the queue for a submission: the hinted node's queue, else the
+ * calling worker's queue, else the queue of the CPU the caller runs on, else
+ * round-robin.
+ */
+static threadpool_queue_t *
+threadpool_select_queue (threadpool_t * p_pool, int node)
+{
+    threadpool_queue_t * p_queue = &p_pool->p_queues[0];
+
+    if (1 == p_pool->num_queues)
+    {
+        goto EXIT;
+    }
+
+    if (THREADPOOL_ANY_NODE != node)
+    {
+        for (int index = 0; index < p_pool->num_queues; index++)
+        {
+            if (node == p_pool->p_queues[index].node)
+            {
+                p_queue = &p_pool->p_queues[index];
+                goto EXIT;
+            }
+        }
+    }
+
+    if (threadpool_is_own_worker(p_pool))
+    {
+        p_queue = gp_current_worker->p_queue;
+        goto EXIT;
+    }
+
+    int cpu = sched_getcpu();
+
+    if ((0 <= cpu) && (cpu < p_pool->num_cpu_ids)
+        && (0 <= p_pool->p_cpu_queue[cpu]))
+    {
+        p_queue = &p_pool->p_queues[p_pool->p_cpu_queue[cpu]];
+        goto EXIT;
+    }
+
+    unsigned int next = atomic_fetch_add_explicit(
+        &p_pool->next_queue, 1, memory_order_relaxed);
+    p_queue = &p_pool->p_queues[next % (unsigned int)p_pool->num_queues];
+
+EXIT:
+    return p_queue;
+}
+
+/**
+ * @brief Wakes one idle worker of a node other than p_busy's, which finds its
+ * own queue empty and steals from the others before sleeping again.
+ */
+static void
+threadpool_wake_remote (threadpool_t * p_pool, threadpool_queue_t * p_busy)
+{
+    int busy = (int)(p_busy - p_pool->p_queues);
+
+    for (int offset = 1; offset < p_pool->num_queues; offset++)
+    {
+        threadpool_queue_t * p_queue
+            = &p_pool->p_queues[(busy + offset) % p_pool->num_queues];
+
+        if (0 == atomic_load_explicit(&p_queue->num_idle, memory_order_relaxed))
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&p_queue->pop_lock);
+        pthread_cond_signal(&p_queue->not_empty);
+        pthread_mutex_unlock(&p_queue->pop_lock);
+        break;
+    }
+}
+
+static int
+threadpool_queue_submit (threadpool_t *       p_pool,
+                         threadpool_queue_t * p_queue,
+                         void (*p_task_function)(void *),
+                         void * p_argument,
+                         bool   b_block,
+                         bool   b_held)
+{
+    int status = 0;
+
+    // Count the task before checking the state so that threadpool_drain()
+    // either sees it outstanding or this call sees the pool draining
+    atomic_fetch_add(&p_pool->outstanding, 1);
+
+    int state = atomic_load(&p_pool->state);
+
+    if ((THREADPOOL_STOPPED == state)
+        || ((THREADPOOL_DRAINING == state) && !b_held
+            && !threadpool_is_own_worker(p_pool)))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    task_t task = { p_task_function, p_argument, 0 };
+
+    if (p_pool->b_telemetry)
+    {
+        task.enqueue_ns = threadpool_now_ns();
+    }
+
+    pthread_mutex_lock(&p_queue->push_lock);
+
+    if (!b_block && (p_queue->capacity == threadpool_queue_size(p_queue)))
+    {
+        pthread_mutex_unlock(&p_queue->push_lock);
+        status = -1;
+        goto EXIT;
+    }
+
+    bool b_blocked = (p_queue->capacity == threadpool_queue_size(p_queue));
+
+    // Wait if the task queue is full, rechecking once the wait is advertised
+    while ((p_queue->capacity == threadpool_queue_size(p_queue))
+           && (THREADPOOL_STOPPED != atomic_load(&p_pool->state)))
+    {
+        atomic_fetch_add(&p_queue->num_blocked, 1);
+
+        if (p_queue->capacity == threadpool_queue_size(p_queue))
+        {
+            pthread_cond_wait(&p_queue->not_full, &p_queue->push_lock);
+        }
+
+        atomic_fetch_sub(&p_queue->num_blocked, 1);
+    }
+
+    // Only a submission that found the queue full counts as blocked; the
+    // wait starts from the submission time taken before the lock
+    if (p_pool->b_telemetry && b_blocked)
+    {
+        uint64_t now = threadpool_now_ns();
+
+        atomic_fetch_add_explicit(
+            &p_queue->blocked_count, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&p_queue->blocked_ns,
+                                  now - task.enqueue_ns,
+                                  memory_order_relaxed);
+        task.enqueue_ns = now;
+    }
+
+    if (THREADPOOL_STOPPED == atomic_load(&p_pool->state))
+    {
+        pthread_mutex_unlock(&p_queue->push_lock);
+        status = -1;
+        goto EXIT;
+    }
+
+    threadpool_queue_push(p_queue, task);
+
+    int depth = threadpool_queue_size(p_queue);
+
+    pthread_mutex_unlock(&p_queue->push_lock);
+    threadpool_queue_wake_consumer(p_queue);
+
+    // The node's own workers are not keeping up; let another node steal
+    if ((1 < p_pool->num_queues) && (THREADPOOL_SPILL_THRESHOLD < depth))
+    {
+        threadpool_wake_remote(p_pool, p_queue);
+    }
+
+EXIT:
+    if (0 != status)
+    {
+        threadpool_task_done(p_pool);
+    }
+
+    return status;
+}
+
+int
+threadpool_task_submit (threadpool_t * p_pool,
+                        void (*p_task_function)(void *),
+                        void * p_argument)
+{
+    return threadpool_submit_on_node(
+        p_pool, THREADPOOL_ANY_NODE, p_task_function, p_argument);
+}
+
+int
+threadpool_submit_on_node (threadpool_t * p_pool,
+                           int            node,
+                           void (*p_task_function)(void *),
+                           void * p_argument)
+{
+    int status = 0;
+
+    if ((NULL == p_pool) || (NULL == p_task_function))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    status = threadpool_queue_submit(p_pool,
+                                     threadpool_select_queue(p_pool, node),
+                                     p_task_function,
+                                     p_argument,
+                                     true,
+                                     false);
+
+EXIT:
+    return status;
+}
+
+int
+threadpool_task_try_submit (threadpool_t * p_pool,
+                            void (*p_task_function)(void *),
+                            void * p_argument)
+{
+    int status = 0;
+
+    if ((NULL == p_pool) || (NULL == p_task_function))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    status = threadpool_queue_submit(
+        p_pool,
+        threadpool_select_queue(p_pool, THREADPOOL_ANY_NODE),
+        p_task_function,
+        p_argument,
+        false,
+        false);
+
+EXIT:
+    return status;
+}
+
+int
+threadpool_hold (threadpool_t * p_pool)
+{
+    int status = 0;
+
+    if (NULL == p_pool)
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    // Counted before the state check, as in threadpool_queue_submit()
+    atomic_fetch_add(&p_pool->outstanding, 1);
+
+    int state = atomic_load(&p_pool->state);
+
+    if ((THREADPOOL_STOPPED == state)
+        || ((THREADPOOL_DRAINING == state)
+            && !threadpool_is_own_worker(p_pool)))
+    {
+        threadpool_task_done(p_pool);
+        status = -1;
+    }
+
+EXIT:
+    return status;
+}
+
+void
+threadpool_release (threadpool_t * p_pool)
+{
+    if (NULL != p_pool)
+    {
+        threadpool_task_done(p_pool);
+    }
+}
+
+int
+threadpool_submit_held (threadpool_t * p_pool,
+                        void (*p_task_function)(void *),
+                        void * p_argument,
+                        bool   b_block)
+{
+    int status = 0;
+
+    if ((NULL == p_pool) || (NULL == p_task_function))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    status = threadpool_queue_submit(
+        p_pool,
+        threadpool_select_queue(p_pool, THREADPOOL_ANY_NODE),
+        p_task_function,
+        p_argument,
+        b_block,
+        true);
+
+EXIT:
+    return status;
+}
+
+static void
+threadpool_timer_swap (threadpool_timer_t * p_first,
+                       threadpool_timer_t * p_second)
+{
+    threadpool_timer_t temp = *p_first;
+    *p_first                = *p_second;
+    *p_second               = temp;
+}
+
+static void
+threadpool_timer_sift_up (threadpool_t * p_pool, size_t index)
+{
+    threadpool_timer_t * p_timers = p_pool->p_timers;
+
+    while (0 < index)
+    {
+        size_t parent = (index - 1) / 2;
+
+        if (p_timers[parent].deadline_ns <= p_timers[index].deadline_ns)
+        {
+            break;
+        }
+
+        threadpool_timer_swap(&p_timers[parent], &p_timers[index]);
+        index = parent;
+    }
+}
+
+static void
+threadpool_timer_sift_down (threadpool_t * p_pool, size_t index)
+{
+    threadpool_timer_t * p_timers = p_pool->p_timers;
+
+    for (;;)
+    {
+        size_t smallest = index;
+        size_t left     = (2 * index) + 1;
+        size_t right    = left + 1;
+
+        if ((left < p_pool->num_timers)
+            && (p_timers[left].deadline_ns < p_timers[smallest].deadline_ns))
+        {
+            smallest = left;
+        }
+
+        if ((right < p_pool->num_timers)
+            && (p_timers[right].deadline_ns < p_timers[smallest].deadline_ns))
+        {
+            smallest = right;
+        }
+
+        if (smallest == index)
+        {
+            break;
+        }
+
+        threadpool_timer_swap(&p_timers[smallest], &p_timers[index]);
+        index = smallest;
+    }
+}
+
+/**
+ * @brief Removes the timer at index from the heap. The timer lock must be
+ * held.
+ */
+static void
+threadpool_timer_remove_at (threadpool_t * p_pool, size_t index)
+{
+    p_pool->num_timers--;
+
+    if (index != p_pool->num_timers)
+    {
+        p_pool->p_timers[index] = p_pool->p_timers[p_pool->num_timers];
+        threadpool_timer_sift_down(p_pool, index);
+        threadpool_timer_sift_up(p_pool, index);
+    }
+}
+
+/**
+ * @brief Publishes the earliest deadline for idle workers. The timer lock
+ * must be held.
+ */
+static void
+threadpool_timer_publish (threadpool_t * p_pool)
+{
+    uint64_t deadline = (0 == p_pool->num_timers)
+                            ? UINT64_MAX
+                            : p_pool->p_timers[0].deadline_ns;
+
+    atomic_store(&p_pool->next_deadline_ns, deadline);
+}
+
+static int
+threadpool_timer_add (threadpool_t * p_pool,
+                      uint64_t       delay_ns,
+                      uint64_t       period_ns,
+                      void (*p_task_function)(void *),
+                      void *     p_argument,
+                      uint64_t * p_timer_id)
+{
+    int  status = 0;
+    bool b_wake = false;
+
+    if ((NULL == p_pool) || (NULL == p_task_function)
+        || (THREADPOOL_RUNNING != atomic_load(&p_pool->state)))
+    {
+        status = -1;
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&p_pool->timer_lock);
+
+    // Checked again under the lock: once the pool stops running its timers
+    // are discarded under this lock, and none may be added afterwards
+    if (THREADPOOL_RUNNING != atomic_load(&p_pool->state))
+    {
+        status = -1;
+        goto EXIT_UNLOCK;
+    }
+
+    if (p_pool->num_timers == p_pool->timer_capacity)
+    {
+        size_t new_capacity = (0 == p_pool->timer_capacity)
+                                  ? THREADPOOL_TIMER_INITIAL_CAPACITY
+                                  : (2 * p_pool->timer_capacity);
+        threadpool_timer_t * p_temp = realloc(
+            p_pool->p_timers, new_capacity * sizeof(threadpool_timer_t));
+
+        if (NULL == p_temp)
+        {
+            fprintf(stderr, "Memory allocation failure.\n");
+            status = -1;
+            goto EXIT_UNLOCK;
+        }
+
+        p_pool->p_timers       = p_temp;
+        p_pool->timer_capacity = new_capacity;
+    }
+
+    threadpool_timer_t timer = { threadpool_now_ns() + delay_ns,
+                                 period_ns,
+                                 ++p_pool->next_timer_id,
+                                 p_task_function,
+                                 p_argument };
+
+    p_pool->p_timers[p_pool->num_timers] = timer;
+    p_pool->num_timers++;
+    threadpool_timer_sift_up(p_pool, p_pool->num_timers - 1);
+
+    if (timer.id == p_pool->p_timers[0].id)
+    {
+        threadpool_timer_publish(p_pool);
+        b_wake = true;
+    }
+
+    if (NULL != p_timer_id)
+    {
+        *p_timer_id = timer.id;
+    }
+
+EXIT_UNLOCK:
+    pthread_mutex_unlock(&p_pool->timer_lock);
+
+    // Idle workers sleep until the old earliest deadline; wake them so they
+    // wait for the new one instead
+    for (int index = 0; b_wake && (index < p_pool->num_queues); index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        pthread_mutex_lock(&p_queue->pop_lock);
+        pthread_cond_broadcast(&p_queue->not_empty);
+        pthread_mutex_unlock(&p_queue->pop_lock);
+    }
+
+EXIT:
+    return status;
+}
+
+int
+threadpool_schedule_after (threadpool_t * p_pool,
+                           uint64_t       delay_ms,
+                           void (*p_task_function)(void *),
+                           void *     p_argument,
+                           uint64_t * p_timer_id)
+{
+    return threadpool_timer_add(p_pool,
+                                delay_ms * THREADPOOL_NS_PER_MS,
+                                0,
+                                p_task_function,
+                                p_argument,
+                                p_timer_id);
+}
+
+int
+threadpool_schedule_every (threadpool_t * p_pool,
+                           uint64_t       period_ms,
+                           void (*p_task_function)(void *),
+                           void *     p_argument,
+                           uint64_t * p_timer_id)
+{
+    int status = -1;
+
+    if (0 != period_ms)
+    {
+        status = threadpool_timer_add(p_pool,
+                                      period_ms * THREADPOOL_NS_PER_MS,
+                                      period_ms * THREADPOOL_NS_PER_MS,
+                                      p_task_function,
+                                      p_argument,
+                                      p_timer_id);
+    }
+
+    return status;
+}
+
+int
+threadpool_timer_cancel (threadpool_t * p_pool, uint64_t timer_id)
+{
+    int status = -1;
 
     if (NULL == p_pool)
     {
-        fprintf(stderr, "Memory allocation failure.\n");
         goto EXIT;
     }
 
-    p_pool->p_tasks = malloc(sizeof(task_t) * THREAD_POOL_SIZE);
+    pthread_mutex_lock(&p_pool->timer_lock);
 
-    if (NULL == p_pool->p_tasks)
+    for (size_t index = 0; index < p_pool->num_timers; index++)
     {
-        free(p_pool);
-        p_pool = NULL;
-        fprintf(stderr, "Memory allocation failure.\n");
-        goto EXIT;
+        if (timer_id == p_pool->p_timers[index].id)
+        {
+            threadpool_timer_remove_at(p_pool, index);
+            threadpool_timer_publish(p_pool);
+            status = 0;
+            break;
+        }
     }
 
-    p_pool->size        = 0;
-    p_pool->front       = 0;
-    p_pool->rear        = 0;
-    p_pool->is_shutdown = 0;
+    pthread_mutex_unlock(&p_pool->timer_lock);
 
-    pthread_mutex_init(&p_pool->lock, NULL);
-    pthread_cond_init(&p_pool->not_empty, NULL);
-    pthread_cond_init(&p_pool->not_full, NULL);
+EXIT:
+    return status;
+}
 
-    p_pool->p_threads = malloc(sizeof(pthread_t) * num_threads);
+void
+threadpool_timers_run_due (threadpool_t * p_pool)
+{
+    threadpool_timer_t batch[THREADPOOL_TIMER_BATCH];
+    size_t             count = 0;
 
-    if (NULL == p_pool->p_threads)
+    if (NULL == p_pool)
     {
-        free(p_pool->p_tasks);
-        p_pool->p_tasks = NULL;
-        free(p_pool);
-        p_pool = NULL;
-        fprintf(stderr, "Memory allocation failure.\n");
         goto EXIT;
     }
 
-    int count = 0;
-
-    for (int index = 0; index < num_threads; index++)
+    do
     {
-        if (0
-            != pthread_create(&p_pool->p_threads[index],
-                              NULL,
-                              threadpool_function,
-                              (void *)p_pool))
+        uint64_t deadline = atomic_load(&p_pool->next_deadline_ns);
+
+        // Cheap exit for the common case: no timers or none due yet
+        if ((UINT64_MAX == deadline)
+            || (THREADPOOL_RUNNING != atomic_load(&p_pool->state)))
         {
-            free(p_pool->p_tasks);
-            p_pool->p_tasks = NULL;
-            fprintf(stderr, "Thread create failure.\n");
+            goto EXIT;
+        }
 
-            for (int thread = 0; thread < index; thread++)
+        uint64_t now = threadpool_now_ns();
+
+        if (now < deadline)
+        {
+            goto EXIT;
+        }
+
+        count = 0;
+        pthread_mutex_lock(&p_pool->timer_lock);
+
+        while ((0 < p_pool->num_timers)
+               && (now >= p_pool->p_timers[0].deadline_ns)
+               && (THREADPOOL_TIMER_BATCH > count))
+        {
+            threadpool_timer_t * p_timer = &p_pool->p_timers[0];
+
+            batch[count] = *p_timer;
+            count++;
+
+            if (0 == p_timer->period_ns)
             {
-                pthread_cancel(p_pool->p_threads[thread]);
+                threadpool_timer_remove_at(p_pool, 0);
             }
+            else
+            {
+                uint64_t missed
+                    = (now - p_timer->deadline_ns) / p_timer->period_ns;
 
-            for (int thread = 0; thread < index; thread++)
+                p_timer->deadline_ns += (missed + 1) * p_timer->period_ns;
+                threadpool_timer_sift_down(p_pool, 0);
+            }
+        }
+
+        threadpool_timer_publish(p_pool);
+        pthread_mutex_unlock(&p_pool->timer_lock);
+
+        for (size_t index = 0; index < count; index++)
+        {
+            threadpool_timer_t * p_timer = &batch[index];
+
+            if (0
+                == threadpool_task_try_submit(
+                    p_pool, p_timer->p_task_function, p_timer->p_argument))
             {
-                pthread_join(p_pool->p_threads[thread], NULL);
+                continue;
             }
 
-            free(p_pool);
-            p_pool = NULL;
-            goto EXIT;
+            // A worker must not block on a full queue it may be the only
+            // consumer of, so it runs the task itself
+            if (threadpool_is_own_worker(p_pool))
+            {
+                p_timer->p_task_function(p_timer->p_argument);
+            }
+            else
+            {
+                threadpool_task_submit(
+                    p_pool, p_timer->p_task_function, p_timer->p_argument);
+            }
         }
+    } while (THREADPOOL_TIMER_BATCH == count);
 
-        count++;
-    }
+EXIT:
+    return;
+}
 
-    p_pool->num_threads = count;
+bool
+threadpool_in_worker (threadpool_t * p_pool)
+{
+    return ((NULL != p_pool) && threadpool_is_own_worker(p_pool));
+}
 
-EXIT:
-    return p_pool;
+int
+threadpool_num_nodes (threadpool_t * p_pool)
+{
+    return (NULL == p_pool) ? 0 : p_pool->num_queues;
 }
 
 void
-threadpool_destroy (threadpool_t * p_pool)
+threadpool_histogram_record (threadpool_histogram_t * p_histogram,
+                             uint64_t                 value)
 {
-    if (NULL != p_pool)
+    if (NULL != p_histogram)
     {
-        printf("Wrapping up threads...\n");
-        pthread_mutex_lock(&p_pool->lock);
-        p_pool->is_shutdown = 1;
-        pthread_mutex_unlock(&p_pool->lock);
+        threadpool_counter_add(
+            &p_histogram->counts[threadpool_histogram_bucket(value)], 1);
+        threadpool_counter_add(&p_histogram->total, 1);
+        threadpool_counter_add(&p_histogram->sum, value);
+
+        if (value > atomic_load_explicit(&p_histogram->max,
+                                         memory_order_relaxed))
+        {
+            atomic_store_explicit(
+                &p_histogram->max, value, memory_order_relaxed);
+        }
+    }
+}
 
-        pthread_cond_broadcast(&p_pool->not_empty);
+uint64_t
+threadpool_histogram_quantile (const threadpool_histogram_t * p_histogram,
+                               double                         quantile)
+{
+    uint64_t value = 0;
 
-        for (int index = 0; index < p_pool->num_threads; index++)
+    if (NULL == p_histogram)
+    {
+        goto EXIT;
+    }
+
+    uint64_t total = atomic_load_explicit(
+        (atomic_uint_least64_t *)&p_histogram->total, memory_order_relaxed);
+    uint64_t seen  = 0;
+
+    if (0 == total)
+    {
+        goto EXIT;
+    }
+
+    // Zero-based rank of the sample holding the quantile; 1.0 and anything
+    // beyond it name the largest sample
+    uint64_t rank = total - 1;
+
+    if (quantile < 1.0)
+    {
+        rank = (0.0 < quantile) ? (uint64_t)(quantile * (double)total) : 0;
+        rank = (rank < total) ? rank : (total - 1);
+    }
+
+    for (size_t bucket = 0; bucket < THREADPOOL_HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += atomic_load_explicit(
+            (atomic_uint_least64_t *)&p_histogram->counts[bucket],
+            memory_order_relaxed);
+
+        if (seen > rank)
         {
-            pthread_join(p_pool->p_threads[index], NULL);
+            value = threadpool_histogram_bucket_value(bucket);
+            break;
         }
+    }
+
+EXIT:
+    return value;
+}
 
-        free(p_pool->p_threads);
-        free(p_pool->p_tasks);
-        p_pool->p_threads = NULL;
-        p_pool->p_tasks   = NULL;
+static void
+threadpool_stats_merge (threadpool_stats_t *       p_total,
+                        const threadpool_stats_t * p_worker)
+{
+    atomic_uint_least64_t *       p_dest = (atomic_uint_least64_t *)p_total;
+    const atomic_uint_least64_t * p_src
+        = (const atomic_uint_least64_t *)p_worker;
 
-        pthread_mutex_destroy(&p_pool->lock);
-        pthread_cond_destroy(&p_pool->not_empty);
-        pthread_cond_destroy(&p_pool->not_full);
+    // Every field of threadpool_stats_t is a 64-bit counter; maxima are fixed
+    // up below
+    for (size_t index = 0; index < (sizeof(*p_total) / sizeof(*p_dest));
+         index++)
+    {
+        uint64_t add = atomic_load_explicit(
+            (atomic_uint_least64_t *)&p_src[index], memory_order_relaxed);
 
-        free(p_pool);
-        p_pool = NULL;
+        atomic_fetch_add_explicit(&p_dest[index], add, memory_order_relaxed);
     }
 }
 
 int
-threadpool_task_submit (threadpool_t * p_pool,
-                        void (*p_task_function)(void *),
-                        void * p_argument)
+threadpool_telemetry_snapshot (threadpool_t *       p_pool,
+                               int                  worker,
+                               threadpool_stats_t * p_stats)
 {
     int status = 0;
 
-    if (NULL == p_pool)
+    if ((NULL == p_pool) || (NULL == p_stats) || !p_pool->b_telemetry
+        || (worker < THREADPOOL_ALL_WORKERS) || (worker >= p_pool->num_threads))
     {
         status = -1;
         goto EXIT;
     }
 
-    pthread_mutex_lock(&p_pool->lock);
+    memset(p_stats, 0, sizeof(*p_stats));
 
-    // Wait if the task queue is full
-    while (THREAD_POOL_SIZE == p_pool->size)
+    bool     b_all     = (THREADPOOL_ALL_WORKERS == worker);
+    int      first     = b_all ? 0 : worker;
+    int      last      = b_all ? p_pool->num_threads : (worker + 1);
+    uint64_t max_wait  = 0;
+    uint64_t max_run   = 0;
+    uint64_t max_depth = 0;
+
+    for (int index = first; index < last; index++)
     {
-        pthread_cond_wait(&p_pool->not_full, &p_pool->lock);
+        threadpool_stats_t * p_worker = p_pool->p_workers[index].p_stats;
+
+        threadpool_stats_merge(p_stats, p_worker);
+
+        uint64_t wait  = atomic_load_explicit(&p_worker->queue_wait.max,
+                                             memory_order_relaxed);
+        uint64_t run   = atomic_load_explicit(&p_worker->run_time.max,
+                                            memory_order_relaxed);
+        uint64_t depth = atomic_load_explicit(&p_worker->queue_depth.max,
+                                              memory_order_relaxed);
+
+        max_wait  = (wait > max_wait) ? wait : max_wait;
+        max_run   = (run > max_run) ? run : max_run;
+        max_depth = (depth > max_depth) ? depth : max_depth;
     }
 
-    task_t task                   = { p_task_function, p_argument };
-    p_pool->p_tasks[p_pool->rear] = task;
-    p_pool->rear                  = (p_pool->rear + 1) % THREAD_POOL_SIZE;
-    p_pool->size++;
+    atomic_store(&p_stats->queue_wait.max, max_wait);
+    atomic_store(&p_stats->run_time.max, max_run);
+    atomic_store(&p_stats->queue_depth.max, max_depth);
+
+    uint64_t queued     = 0;
+    uint64_t high_water = 0;
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        queued += (uint64_t)threadpool_queue_size(p_queue);
+
+        pthread_mutex_lock(&p_queue->push_lock);
+
+        if ((uint64_t)p_queue->high_water > high_water)
+        {
+            high_water = (uint64_t)p_queue->high_water;
+        }
+
+        pthread_mutex_unlock(&p_queue->push_lock);
+
+        atomic_fetch_add(&p_stats->submit_blocked_count,
+                         atomic_load(&p_queue->blocked_count));
+        atomic_fetch_add(&p_stats->submit_blocked_ns,
+                         atomic_load(&p_queue->blocked_ns));
+    }
 
-    pthread_cond_signal(&p_pool->not_empty);
-    pthread_mutex_unlock(&p_pool->lock);
+    atomic_store(&p_stats->queued, queued);
+    atomic_store(&p_stats->queue_high_water, high_water);
 
 EXIT:
     return status;
 }
 
-int
-threadpool_task_execute (threadpool_t * p_pool)
+void
+threadpool_telemetry_reset (threadpool_t * p_pool)
 {
-    int status = 0;
-
-    if (NULL == p_pool)
+    if ((NULL == p_pool) || !p_pool->b_telemetry)
     {
-        status = -1;
         goto EXIT;
     }
 
-    task_t task;
+    for (int index = 0; index < p_pool->num_threads; index++)
+    {
+        atomic_uint_least64_t * p_counter
+            = (atomic_uint_least64_t *)p_pool->p_workers[index].p_stats;
+
+        for (size_t field = 0;
+             field < (sizeof(threadpool_stats_t) / sizeof(*p_counter));
+             field++)
+        {
+            atomic_store_explicit(&p_counter[field], 0, memory_order_relaxed);
+        }
+    }
+
+    for (int index = 0; index < p_pool->num_queues; index++)
+    {
+        threadpool_queue_t * p_queue = &p_pool->p_queues[index];
+
+        pthread_mutex_lock(&p_queue->push_lock);
+        p_queue->high_water = threadpool_queue_size(p_queue);
+        pthread_mutex_unlock(&p_queue->push_lock);
+
+        atomic_store(&p_queue->blocked_count, 0);
+        atomic_store(&p_queue->blocked_ns, 0);
+    }
+
+EXIT:
+    return;
+}
+
+/**
+ * @brief Takes a task from another node's queue without blocking on its lock.
+ *
+ * @return true if a task was stored in p_task.
+ */
+static bool
+threadpool_task_steal (threadpool_worker_t * p_worker, task_t * p_task)
+{
+    threadpool_t * p_pool  = p_worker->p_pool;
+    int            own     = (int)(p_worker->p_queue - p_pool->p_queues);
+    bool           b_found = false;
+
+    for (int offset = 1; (offset < p_pool->num_queues) && !b_found; offset++)
+    {
+        threadpool_queue_t * p_victim
+            = &p_pool->p_queues[(own + offset) % p_pool->num_queues];
+
+        if (0 != pthread_mutex_trylock(&p_victim->pop_lock))
+        {
+            continue;
+        }
+
+        if (0 < threadpool_queue_size(p_victim))
+        {
+            *p_task = threadpool_queue_pop(p_victim);
+            b_found = true;
+        }
+
+        pthread_mutex_unlock(&p_victim->pop_lock);
+
+        if (b_found)
+        {
+            threadpool_queue_wake_producer(p_victim);
+        }
+    }
+
+    return b_found;
+}
+
+/**
+ * @brief Executes one task on behalf of p_worker, which is either one of the
+ * pool's workers or a stand-in for a thread helping out.
+ */
+static int
+threadpool_worker_execute (threadpool_worker_t * p_worker)
+{
+    int status = 0;
+
+    threadpool_t *       p_pool   = p_worker->p_pool;
+    threadpool_queue_t * p_queue  = p_worker->p_queue;
+    threadpool_stats_t * p_stats  = p_worker->p_stats;
+    uint64_t             start_ns = 0;
+    int                  depth    = 0;
+    task_t               task;
+
+    if (NULL != p_stats)
+    {
+        start_ns = threadpool_now_ns();
+    }
 
-    pthread_mutex_lock(&p_pool->lock);
+    threadpool_timers_run_due(p_pool);
+    pthread_mutex_lock(&p_queue->pop_lock);
 
-    // Wait if the task queue is empty
-    while ((0 == p_pool->size) && (0 == p_pool->is_shutdown))
+    // Wait if the task queue is empty, looking at other nodes first
+    while ((0 == threadpool_queue_size(p_queue))
+           && (THREADPOOL_STOPPED != atomic_load(&p_pool->state)))
     {
-        pthread_cond_wait(&p_pool->not_empty, &p_pool->lock);
+        if (1 < p_pool->num_queues)
+        {
+            pthread_mutex_unlock(&p_queue->pop_lock);
+
+            if (threadpool_task_steal(p_worker, &task))
+            {
+                if (NULL != p_stats)
+                {
+                    threadpool_counter_add(&p_stats->tasks_stolen, 1);
+                }
+
+                goto RUN;
+            }
+
+            pthread_mutex_lock(&p_queue->pop_lock);
+
+            if ((0 != threadpool_queue_size(p_queue))
+                || (THREADPOOL_STOPPED == atomic_load(&p_pool->state)))
+            {
+                break;
+            }
+        }
+
+        uint64_t deadline    = atomic_load(&p_pool->next_deadline_ns);
+        int      wait_status = 0;
+
+        // Counted while asleep so that producers, including those of a
+        // backed-up node, know to wake us; the queue is checked once more
+        // after the count is visible
+        atomic_fetch_add(&p_queue->num_idle, 1);
+
+        if ((0 == threadpool_queue_size(p_queue)) && (UINT64_MAX == deadline))
+        {
+            pthread_cond_wait(&p_queue->not_empty, &p_queue->pop_lock);
+        }
+        else if (0 == threadpool_queue_size(p_queue))
+        {
+            struct timespec wake
+                = { (time_t)(deadline / THREADPOOL_NS_PER_SEC),
+                    (long)(deadline % THREADPOOL_NS_PER_SEC) };
+
+            wait_status = pthread_cond_timedwait(
+                &p_queue->not_empty, &p_queue->pop_lock, &wake);
+        }
+
+        atomic_fetch_sub(&p_queue->num_idle, 1);
+
+        if (ETIMEDOUT == wait_status)
+        {
+            pthread_mutex_unlock(&p_queue->pop_lock);
+            threadpool_timers_run_due(p_pool);
+            pthread_mutex_lock(&p_queue->pop_lock);
+        }
     }
 
-    if (1 == p_pool->is_shutdown)
+    if (THREADPOOL_STOPPED == atomic_load(&p_pool->state))
     {
-        pthread_mutex_unlock(&p_pool->lock);
+        pthread_mutex_unlock(&p_queue->pop_lock);
         status = -1;
         goto EXIT;
     }
 
-    task          = p_pool->p_tasks[p_pool->front];
-    p_pool->front = (p_pool->front + 1) % THREAD_POOL_SIZE;
-    p_pool->size--;
+    depth = threadpool_queue_size(p_queue);
+    task  = threadpool_queue_pop(p_queue);
+
+    pthread_mutex_unlock(&p_queue->pop_lock);
+    threadpool_queue_wake_producer(p_queue);
 
-    pthread_cond_signal(&p_pool->not_full);
-    pthread_mutex_unlock(&p_pool->lock);
+RUN:
+    if (NULL != p_stats)
+    {
+        uint64_t now = threadpool_now_ns();
+
+        threadpool_counter_add(&p_stats->idle_ns, now - start_ns);
+        threadpool_histogram_record(&p_stats->queue_wait,
+                                    now - task.enqueue_ns);
+        threadpool_histogram_record(&p_stats->queue_depth, (uint64_t)depth);
+        start_ns = now;
+    }
 
     // Execute the task
     task.p_task_function(task.p_argument);
 
+    if (NULL != p_stats)
+    {
+        uint64_t run_ns = threadpool_now_ns() - start_ns;
+
+        threadpool_counter_add(&p_stats->busy_ns, run_ns);
+        threadpool_counter_add(&p_stats->tasks_executed, 1);
+        threadpool_histogram_record(&p_stats->run_time, run_ns);
+    }
+
+    threadpool_task_done(p_pool);
+
+EXIT:
+    return status;
+}
+
+int
+threadpool_task_execute (threadpool_t * p_pool)
+{
+    int status = -1;
+
+    if (NULL == p_pool)
+    {
+        goto EXIT;
+    }
+
+    if (threadpool_is_own_worker(p_pool))
+    {
+        status = threadpool_worker_execute(gp_current_worker);
+        goto EXIT;
+    }
+
+    // A helping thread borrows the queue of the node it runs on and records
+    // no telemetry
+    threadpool_worker_t helper = { 0 };
+
+    helper.p_pool  = p_pool;
+    helper.p_queue = threadpool_select_queue(p_pool, THREADPOOL_ANY_NODE);
+    helper.id      = -1;
+    helper.cpu     = -1;
+    helper.p_stats = NULL;
+
+    status = threadpool_worker_execute(&helper);
+
 EXIT:
     return status;
 }
 
 void *
-threadpool_function (void * arg)
+threadpool_function (void * p_arg)
 {
-    threadpool_t * p_pool = (threadpool_t *)arg;
+    threadpool_t * p_pool = (threadpool_t *)p_arg;
 
     for (;;)
     {
@@ -204,4 +1960,29 @@ threadpool_function (void * arg)
     return NULL;
 }
 
+/**
+ * @brief Thread function of the pool's own workers.
+ */
+static void *
+threadpool_worker_main (void * p_arg)
+{
+    threadpool_worker_t * p_worker = (threadpool_worker_t *)p_arg;
+
+    gp_current_worker = p_worker;
+
+    for (;;)
+    {
+        int status = threadpool_worker_execute(p_worker);
+
+        if (-1 == status)
+        {
+            break;
+        }
+    }
+
+    gp_current_worker = NULL;
+
+    return NULL;
+}
+
 // End of threadpool.c
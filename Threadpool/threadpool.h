@@ -9,15 +9,61 @@
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
-#define THREAD_POOL_SIZE 10 /**< Default size of the thread pool. */
+#define THREAD_POOL_SIZE 10 /**< Default capacity of each task queue. */
+
+#define THREADPOOL_MAX_NODES 64 /**< Highest NUMA node id probed at init. */
+
+#define THREADPOOL_ANY_NODE -1 /**< Node hint meaning "no preference". */
+
+#define THREADPOOL_ALL_WORKERS -1 /**< Aggregate telemetry of all workers. */
+
+#define THREADPOOL_TIMER_BATCH 64 /**< Timers fired per timer-lock hold. */
+
+/**
+ * @brief Queue depth beyond which a submission also wakes an idle worker of
+ * another node, which then steals from the backed-up queue.
+ */
+#define THREADPOOL_SPILL_THRESHOLD 2
+
+/**
+ * @brief Size of a cache line. Fields written by different threads are kept
+ * at least this far apart so their writes do not invalidate each other.
+ */
+#define THREADPOOL_CACHE_LINE 64
+
+/**
+ * @brief Number of linear sub-buckets per power of two in telemetry
+ * histograms, as a power of two. Recorded values are kept to within 1/16.
+ */
+#define THREADPOOL_HISTOGRAM_SUB_BITS 4
+
+/**
+ * @brief Number of buckets needed to cover every 64-bit nanosecond value.
+ */
+#define THREADPOOL_HISTOGRAM_BUCKETS \
+    ((65 - THREADPOOL_HISTOGRAM_SUB_BITS) << THREADPOOL_HISTOGRAM_SUB_BITS)
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
 #include <string.h>
 #include <unistd.h>
 #include <openssl/ssl.h>
 
+/**
+ * @brief Lifecycle states of a thread pool.
+ */
+typedef enum threadpool_state_t
+{
+    THREADPOOL_RUNNING  = 0, /**< Accepting and executing tasks. */
+    THREADPOOL_DRAINING = 1, /**< Finishing queued tasks; only workers may
+                                  submit. */
+    THREADPOOL_STOPPED  = 2, /**< Workers exit without taking more tasks. */
+} threadpool_state_t;
+
 /**
  * @brief Structure representing an argument to a task to be executed by the
  * thread pool.
@@ -26,28 +72,174 @@ typedef struct task_t
 {
     void (*p_task_function)(void *); /**< Pointer to the task function. */
     void * p_argument; /**< Pointer to the argument for the task function. */
+    uint64_t enqueue_ns; /**< Submission time, set when telemetry is on. */
 } task_t;
 
+/**
+ * @brief A delayed or periodic task waiting in the pool's timer heap.
+ */
+typedef struct threadpool_timer_t
+{
+    uint64_t deadline_ns; /**< Monotonic time at which the timer fires. */
+    uint64_t period_ns;   /**< Re-arm interval, or 0 for one-shot timers. */
+    uint64_t id;          /**< Identifier returned to the caller. */
+    void (*p_task_function)(void *); /**< Pointer to the task function. */
+    void * p_argument; /**< Pointer to the argument for the task function. */
+} threadpool_timer_t;
+
+/**
+ * @brief Log-linear (HDR-style) histogram of nanosecond values.
+ *
+ * Values below 2^THREADPOOL_HISTOGRAM_SUB_BITS get a bucket each; above that,
+ * every power of two is split into 2^THREADPOOL_HISTOGRAM_SUB_BITS buckets.
+ */
+typedef struct threadpool_histogram_t
+{
+    atomic_uint_least64_t
+        counts[THREADPOOL_HISTOGRAM_BUCKETS]; /**< Samples per bucket. */
+    atomic_uint_least64_t total;  /**< Number of samples recorded. */
+    atomic_uint_least64_t sum;    /**< Sum of all recorded values. */
+    atomic_uint_least64_t max;    /**< Largest recorded value. */
+} threadpool_histogram_t;
+
+/**
+ * @brief Telemetry counters. Live per-worker counters are only written by
+ * their worker; snapshots aggregate them with relaxed loads.
+ *
+ * Every field, including those of the histograms, is an atomic 64-bit counter
+ * so that snapshots can merge and reset the structure field by field.
+ */
+typedef struct threadpool_stats_t
+{
+    _Alignas(THREADPOOL_CACHE_LINE)
+        atomic_uint_least64_t tasks_executed; /**< Tasks run to completion. */
+    atomic_uint_least64_t tasks_stolen; /**< Tasks taken from other nodes. */
+    atomic_uint_least64_t busy_ns; /**< Time spent running tasks. */
+    atomic_uint_least64_t idle_ns; /**< Time spent waiting for tasks. */
+    atomic_uint_least64_t
+        submit_blocked_count; /**< Submissions that waited on a full queue. */
+    atomic_uint_least64_t
+        submit_blocked_ns; /**< Time producers spent waiting on not_full. */
+    atomic_uint_least64_t queued; /**< Tasks queued when the snapshot was
+                                       taken (snapshots only). */
+    atomic_uint_least64_t
+        queue_high_water; /**< Deepest any queue has been. */
+    threadpool_histogram_t
+        queue_wait; /**< Time from submission to start of execution. */
+    threadpool_histogram_t run_time; /**< Execution time of tasks. */
+    threadpool_histogram_t
+        queue_depth; /**< Queue depth seen by workers taking a task. */
+} threadpool_stats_t;
+
+/**
+ * @brief Optional creation attributes for a thread pool.
+ *
+ * A zero-initialized structure gives the behaviour of threadpool_init().
+ */
+typedef struct threadpool_attr_t
+{
+    bool b_numa_aware;  /**< Create one task queue per NUMA node and keep
+                             each worker on the CPUs of its node. */
+    bool b_pin_workers; /**< Pin each worker to a single CPU. */
+    int  queue_capacity; /**< Capacity of each task queue, or 0 for
+                              THREAD_POOL_SIZE. */
+    bool b_telemetry; /**< Collect the counters and histograms read by
+                           threadpool_telemetry_snapshot(). */
+} threadpool_attr_t;
+
+/**
+ * @brief Bounded task queue. A pool has one queue per NUMA node it serves.
+ *
+ * Producers and consumers work on separate halves, each with its own lock and
+ * cache line: producers append at rear under push_lock, consumers take from
+ * front under pop_lock. rear and front count every task ever pushed and
+ * popped, so the depth is their difference. Each side reads the other's
+ * index only to tell whether the queue is empty or full. A side takes the
+ * other side's lock only to wake a thread sleeping there, which the sleeper
+ * advertises in num_idle or num_blocked.
+ */
+typedef struct threadpool_queue_t
+{
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_mutex_t
+        push_lock; /**< Mutex serializing producers. */
+    atomic_uint_least64_t rear; /**< Number of tasks ever pushed. */
+    int high_water; /**< Deepest the queue has been, under push_lock. */
+    atomic_int num_blocked; /**< Producers asleep on not_full. */
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_cond_t
+        not_full; /**< Condition variable for signaling non-full tasks. */
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_mutex_t
+        pop_lock; /**< Mutex serializing consumers. */
+    atomic_uint_least64_t front; /**< Number of tasks ever popped. */
+    atomic_int num_idle; /**< Workers asleep on not_empty, read by other
+                              nodes' producers without the lock. */
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_cond_t
+        not_empty; /**< Condition variable for signaling non-empty tasks. */
+    _Alignas(THREADPOOL_CACHE_LINE)
+        task_t * p_tasks; /**< Ring buffer of tasks to be executed. */
+    int   capacity;       /**< Capacity of the ring buffer. */
+    int   node;           /**< NUMA node served by this queue. */
+    int * p_cpus;         /**< CPUs belonging to the node. */
+    int   num_cpus;       /**< Number of entries in p_cpus. */
+    _Alignas(THREADPOOL_CACHE_LINE) atomic_uint_least64_t
+        blocked_count; /**< Submissions that waited on not_full. */
+    atomic_uint_least64_t
+        blocked_ns; /**< Time producers spent waiting on not_full. */
+} threadpool_queue_t;
+
+struct threadpool_t;
+
+/**
+ * @brief Per-thread state of a pool worker, one cache line per worker.
+ */
+typedef struct threadpool_worker_t
+{
+    _Alignas(THREADPOOL_CACHE_LINE)
+        struct threadpool_t * p_pool; /**< Owning thread pool. */
+    threadpool_queue_t *  p_queue; /**< Node-local queue served first. */
+    pthread_t             thread;  /**< Worker thread handle. */
+    int                   id;      /**< Index of the worker in the pool. */
+    int                   cpu;     /**< CPU the worker is pinned to, or -1. */
+    threadpool_stats_t *  p_stats; /**< Telemetry, or NULL when disabled. */
+} threadpool_worker_t;
+
 /**
  * @brief Structure representing a simple thread pool.
+ *
+ * Fields read on every submission or task are grouped on a read-mostly line.
+ * The submission cursor, written by producers, and the outstanding count,
+ * written by producers and workers alike, each get a line of their own, as do
+ * the idle wait and the timer heap.
  */
 typedef struct threadpool_t
 {
+    _Alignas(THREADPOOL_CACHE_LINE)
+        threadpool_queue_t * p_queues; /**< Task queues, one per node. */
+    int                   num_queues;  /**< Number of task queues. */
+    threadpool_worker_t * p_workers;   /**< Workers of the pool. */
+    int                   num_threads; /**< Number of threads in the pool. */
+    int *                 p_cpu_queue; /**< Maps a CPU id to a queue index. */
+    int                   num_cpu_ids; /**< Number of entries in p_cpu_queue. */
+    atomic_int            state; /**< Current threadpool_state_t of the pool. */
+    bool                  b_telemetry; /**< Whether telemetry is collected. */
+    _Alignas(THREADPOOL_CACHE_LINE)
+        atomic_uint next_queue; /**< Round-robin submission cursor. */
+    _Alignas(THREADPOOL_CACHE_LINE)
+        atomic_long outstanding; /**< Tasks submitted but not yet finished. */
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_mutex_t
+        idle_lock; /**< Mutex protecting the idle condition variable. */
+    pthread_cond_t idle; /**< Condition variable signaling that no task is
+                            queued or running. */
     pthread_mutex_t
-        lock; /**< Mutex for thread-safe access to the thread pool. */
-    pthread_cond_t
-        not_empty; /**< Condition variable for signaling non-empty tasks. */
-    pthread_cond_t
-        not_full; /**< Condition variable for signaling non-full tasks. */
-    pthread_t *
-             p_threads; /**< Array of pthreads representing the thread pool. */
-    task_t * p_tasks;   /**< Array of tasks to be executed. */
-    int      size;      /**< Size of the task array. */
-    int      front;     /**< Index of the front of the task array. */
-    int      rear;      /**< Index of the rear of the task array. */
-    int      num_threads; /**< Number of threads in the pool. */
-    int is_shutdown; /**< Flag indicating whether the thread pool is shutdown.
-                      */
+         control_lock; /**< Mutex serializing the stopping of workers. */
+    bool b_joined;     /**< Whether the workers have been joined. */
+    _Alignas(THREADPOOL_CACHE_LINE) pthread_mutex_t
+        timer_lock; /**< Mutex for thread-safe access to the timer heap. */
+    threadpool_timer_t * p_timers; /**< Min-heap of timers by deadline. */
+    size_t               num_timers;     /**< Number of armed timers. */
+    size_t               timer_capacity; /**< Capacity of the timer heap. */
+    uint64_t             next_timer_id;  /**< Identifier of the next timer. */
+    atomic_uint_least64_t
+        next_deadline_ns; /**< Earliest timer deadline, UINT64_MAX if none. */
 } threadpool_t;
 
 /**
@@ -58,36 +250,353 @@ typedef struct threadpool_t
  */
 threadpool_t * threadpool_init (int num_threads);
 
+/**
+ * @brief Initializes a thread pool with the specified number of threads and
+ * creation attributes.
+ *
+ * When p_attr->b_numa_aware is set, the pool discovers the NUMA nodes
+ * available to the process, creates one task queue per node (up to one per
+ * worker) and spreads the workers over the nodes. On hosts with a single node,
+ * or where the topology cannot be read, the pool falls back to one queue.
+ *
+ * @param num_threads The number of threads to be created in the thread pool.
+ * @param p_attr Creation attributes, or NULL for the defaults.
+ * @return A pointer to the newly initialized thread pool.
+ * @warning Returns NULL in the event of memory allocation failure or thread
+ * creation failure. Failing to apply CPU affinity is not fatal.
+ */
+threadpool_t * threadpool_init_attr (int                       num_threads,
+                                     const threadpool_attr_t * p_attr);
+
 /**
  * @brief Destroys a thread pool, freeing allocated memory.
  *
+ * Queued tasks are executed first, as with threadpool_drain(), unless the pool
+ * was already stopped by threadpool_drain() or threadpool_shutdown_now().
+ *
  * @param p_pool A pointer to the thread pool to be destroyed.
+ * @warning Does nothing if called from one of the pool's own workers, which
+ * would have to wait for itself and then free its own resources.
  */
 void threadpool_destroy (threadpool_t * p_pool);
 
+/**
+ * @brief Blocks until every submitted task has finished executing.
+ *
+ * The pool keeps accepting tasks; the call returns the first time it observes
+ * no queued or running task.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if p_pool is NULL or if called from one of the pool's
+ * own workers, which would wait for itself.
+ */
+int threadpool_wait_idle (threadpool_t * p_pool);
+
+/**
+ * @brief Stops accepting new tasks, finishes all queued work and stops the
+ * workers.
+ *
+ * While draining, tasks already running may still submit follow-up tasks;
+ * submissions from other threads fail. The pool must still be destroyed with
+ * threadpool_destroy().
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if p_pool is NULL or if called from one of the pool's
+ * own workers.
+ */
+int threadpool_drain (threadpool_t * p_pool);
+
+/**
+ * @brief Stops the workers as soon as their current task finishes and returns
+ * the tasks that were never executed.
+ *
+ * Producers blocked on a full queue are released and their submission fails.
+ * The pool must still be destroyed with threadpool_destroy().
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param p_count Receives the number of returned tasks.
+ * @return A malloc'd array of the unexecuted tasks, in queue order per node,
+ * which the caller must free, or NULL if there were none.
+ * @warning Returns NULL with *p_count set to 0 if p_pool is NULL, if called
+ * from one of the pool's own workers, or in the event of memory allocation
+ * failure (the unexecuted tasks are then dropped).
+ */
+task_t * threadpool_shutdown_now (threadpool_t * p_pool, size_t * p_count);
+
 /**
  * @brief Submits a task to the thread pool for execution.
  *
+ * Tasks submitted from a pool worker go to that worker's queue; other callers
+ * are routed to the queue of the node they are running on, if known.
+ *
  * @param pool A pointer to the thread pool.
  * @param task_function Pointer to the function representing the task.
  * @param p_argument Pointer to the argument for the task function.
  * @return An integer indicating the success of submitting the task.
+ * @warning Returns -1 once the pool is draining (except from its own
+ * workers) or stopped.
  */
 int threadpool_task_submit (threadpool_t * pool,
                             void (*task_function)(void *),
                             void * p_argument);
 
 /**
- * @brief Executes a task from the thread pool.
+ * @brief Submits a task to the queue serving the given NUMA node.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param node NUMA node the task should run on, or THREADPOOL_ANY_NODE.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @return 0 on success, -1 on failure.
+ * @note The node is a hint: if the pool has no queue for it the task is
+ * submitted as with threadpool_task_submit(), and idle workers of other nodes
+ * may still take the task.
+ */
+int threadpool_submit_on_node (threadpool_t * p_pool,
+                               int            node,
+                               void (*p_task_function)(void *),
+                               void * p_argument);
+
+/**
+ * @brief Submits a task only if its queue has room.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 without blocking when the selected queue is full, in
+ * addition to the failure cases of threadpool_task_submit().
+ */
+int threadpool_task_try_submit (threadpool_t * p_pool,
+                                void (*p_task_function)(void *),
+                                void * p_argument);
+
+/**
+ * @brief Counts work the pool holds in no queue, such as a suspended
+ * coroutine, as outstanding until threadpool_release().
+ *
+ * threadpool_wait_idle() and threadpool_drain() wait for held work as they
+ * do for queued tasks, and tasks continuing it may be submitted with
+ * threadpool_submit_held() while the pool drains.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 in the same cases threadpool_task_submit() does.
+ */
+int threadpool_hold (threadpool_t * p_pool);
+
+/**
+ * @brief Ends one unit of work counted by threadpool_hold().
+ *
+ * @param p_pool A pointer to the thread pool.
+ */
+void threadpool_release (threadpool_t * p_pool);
+
+/**
+ * @brief Submits a task continuing work counted by threadpool_hold().
+ *
+ * Unlike other submissions this one is accepted from any thread while the
+ * pool drains, since the hold keeps the drain from finishing first.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @param b_block Whether to wait for room in a full queue.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a pointer is NULL, the pool is stopped, or b_block
+ * is false and the queue is full.
+ */
+int threadpool_submit_held (threadpool_t * p_pool,
+                            void (*p_task_function)(void *),
+                            void * p_argument,
+                            bool   b_block);
+
+/**
+ * @brief Runs a task once after a delay.
+ *
+ * Timers live in a heap serviced by the pool's workers: an idle worker sleeps
+ * until the earliest deadline, and busy workers check for due timers between
+ * tasks. A timer is late by at most the wake-up latency while a worker is
+ * idle, or by the remainder of the shortest running task otherwise.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param delay_ms Milliseconds to wait before submitting the task.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @param p_timer_id Receives an identifier for threadpool_timer_cancel(), may
+ * be NULL.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a required pointer is NULL, the pool is no longer
+ * running, or in the event of memory allocation failure. Timers that have not
+ * fired when the pool starts draining are discarded.
+ */
+int threadpool_schedule_after (threadpool_t * p_pool,
+                               uint64_t       delay_ms,
+                               void (*p_task_function)(void *),
+                               void *     p_argument,
+                               uint64_t * p_timer_id);
+
+/**
+ * @brief Runs a task every period_ms milliseconds, starting one period from
+ * now, until cancelled.
+ *
+ * Deadlines advance by whole periods from the first one so the schedule does
+ * not drift; periods missed while every worker was busy are skipped rather
+ * than fired back to back. Runs may overlap if the task takes longer than the
+ * period.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param period_ms Interval between runs in milliseconds, at least 1.
+ * @param p_task_function Pointer to the function representing the task.
+ * @param p_argument Pointer to the argument for the task function.
+ * @param p_timer_id Receives an identifier for threadpool_timer_cancel(), may
+ * be NULL.
+ * @return 0 on success, -1 on failure.
+ * @warning Same failure cases as threadpool_schedule_after(), and returns -1
+ * if period_ms is 0.
+ */
+int threadpool_schedule_every (threadpool_t * p_pool,
+                               uint64_t       period_ms,
+                               void (*p_task_function)(void *),
+                               void *     p_argument,
+                               uint64_t * p_timer_id);
+
+/**
+ * @brief Disarms a timer.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param timer_id Identifier returned when the timer was scheduled.
+ * @return 0 if the timer was disarmed, -1 if it was not found, which includes
+ * one-shot timers that already fired. A run already submitted is not
+ * recalled.
+ */
+int threadpool_timer_cancel (threadpool_t * p_pool, uint64_t timer_id);
+
+/**
+ * @brief Submits the tasks of all timers whose deadline has passed.
+ *
+ * Called by workers before taking a task; returns immediately when nothing is
+ * due or another thread is already firing timers.
+ *
+ * @param p_pool A pointer to the thread pool.
+ */
+void threadpool_timers_run_due (threadpool_t * p_pool);
+
+/**
+ * @brief Reports whether the calling thread is one of the pool's workers.
+ *
+ * Blocking helpers built on the pool use this to refuse waits that would
+ * occupy the worker they are waiting for.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @return true if called from a worker of p_pool, false otherwise.
+ */
+bool threadpool_in_worker (threadpool_t * p_pool);
+
+/**
+ * @brief Returns the number of NUMA nodes (task queues) used by the pool.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @return The number of nodes, or 0 if p_pool is NULL.
+ */
+int threadpool_num_nodes (threadpool_t * p_pool);
+
+/**
+ * @brief Copies the pool's telemetry into p_stats.
+ *
+ * Counters are read with relaxed loads while the pool keeps running, so a
+ * snapshot is consistent per counter but not across counters. The
+ * submit-blocked, queued and high-water fields are pool-wide and reported in
+ * every snapshot.
+ *
+ * @param p_pool A pointer to the thread pool.
+ * @param worker Index of the worker to report, or THREADPOOL_ALL_WORKERS.
+ * @param p_stats Receives the snapshot.
+ * @return 0 on success, -1 on failure.
+ * @warning Returns -1 if a pointer is NULL, the worker index is out of range
+ * or the pool was created without b_telemetry.
+ */
+int threadpool_telemetry_snapshot (threadpool_t *       p_pool,
+                                   int                  worker,
+                                   threadpool_stats_t * p_stats);
+
+/**
+ * @brief Zeroes the pool's telemetry. Samples recorded concurrently with the
+ * reset may be lost.
+ *
+ * @param p_pool A pointer to the thread pool.
+ */
+void threadpool_telemetry_reset (threadpool_t * p_pool);
+
+/**
+ * @brief Adds a value to a histogram. Intended for a single writer.
+ *
+ * @param p_histogram A pointer to the histogram.
+ * @param value The value to record.
+ */
+void threadpool_histogram_record (threadpool_histogram_t * p_histogram,
+                                  uint64_t                 value);
+
+/**
+ * @brief Returns the value below which the given fraction of samples fall.
+ *
+ * @param p_histogram A pointer to the histogram.
+ * @param quantile Fraction between 0.0 and 1.0, e.g. 0.99.
+ * @return The lowest value of the bucket holding the quantile, or 0 if the
+ * histogram is empty or NULL.
+ */
+uint64_t threadpool_histogram_quantile (
+    const threadpool_histogram_t * p_histogram, double quantile);
+
+/**
+ * @brief Returns the number of tasks in a queue, without locking.
+ *
+ * @param p_queue A pointer to the queue.
+ * @return The number of queued tasks.
+ */
+int threadpool_queue_size (threadpool_queue_t * p_queue);
+
+/**
+ * @brief Appends a task to a queue. push_lock must be held and the queue
+ * must not be full. Sleeping consumers are not woken.
+ *
+ * @param p_queue A pointer to the queue.
+ * @param task The task to append.
+ */
+void threadpool_queue_push (threadpool_queue_t * p_queue, task_t task);
+
+/**
+ * @brief Removes the front task from a queue. pop_lock must be held and the
+ * queue must not be empty. Sleeping producers are not woken.
+ *
+ * @param p_queue A pointer to the queue.
+ * @return The removed task.
+ */
+task_t threadpool_queue_pop (threadpool_queue_t * p_queue);
+
+/**
+ * @brief Executes one task from the thread pool on the calling thread,
+ * waiting for one if every queue is empty.
+ *
+ * Called from a worker, the worker's own queue is served first. Other threads
+ * are served from the queue of the CPU they run on and take no part in
+ * telemetry. When the chosen queue is empty, a task is taken from any other
+ * queue whose lock is uncontended before going to sleep.
  *
  * @param pool A pointer to the thread pool.
  * @return An integer indicating the success of executing the task.
+ * @warning Returns -1 without running a task once the pool is stopped.
  */
 int threadpool_task_execute (threadpool_t * pool);
 
 /**
  * @brief Function representing the behavior of each thread in the thread pool.
  *
+ * The pool's own workers run an internal loop; a thread started on this
+ * function helps execute tasks until the pool is stopped.
+ *
  * @param p_arg A pointer to the thread pool.
  * @return A pointer to the result of the thread execution.
  */